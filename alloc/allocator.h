@@ -0,0 +1,48 @@
+#ifndef DARC_ALLOCATOR_H
+#define DARC_ALLOCATOR_H
+
+#include <stddef.h> /* size_t, NULL */
+
+/* A stateful allocator, which individual arrays can be pointed at.
+ *
+ * Unlike the realloc()/free() pairs darc is otherwise configured with,
+ * it carries a context (say, an arena or a pool) and is told the current
+ * size of every block, so it needs no bookkeeping of its own to grow
+ * blocks in place or to release them all at once.
+ *
+ * Where,
+ * - "realloc" behaves like stdlib realloc(p, newsz), given ctx and oldsz,
+ *   the size p was last (re)allocated with; oldsz is 0 if p is NULL.
+ * - "free" behaves like stdlib free(p), given ctx and sz, the size p was
+ *   last (re)allocated with. It may be NULL if blocks need not be freed
+ *   individually, as when they are all released with the context.
+ * - "ctx" is passed unchanged to both.
+ *
+ * Arrays with no allocator (a NULL pointer to one) use the realloc()/free()
+ * pair of their implementation, which remains the default.
+ */
+typedef struct darc_allocator {
+	void *(*realloc)(void *ctx, void *p, size_t oldsz, size_t newsz);
+	void  (*free)   (void *ctx, void *p, size_t sz);
+	void *ctx;
+} darc_allocator;
+
+/* Reallocates p with a, or with dflt if a is NULL */
+static inline void *darc_realloc(const darc_allocator *a,
+		void *(*dflt)(void *, size_t), void *p,
+		size_t oldsz, size_t newsz)
+{
+	return a ? a->realloc(a->ctx, p, oldsz, newsz) : dflt(p, newsz);
+}
+
+/* Frees p with a, or with dflt if a is NULL */
+static inline void darc_free(const darc_allocator *a,
+		void (*dflt)(void *), void *p, size_t sz)
+{
+	if (!a)
+		dflt(p);
+	else if (a->free && p)
+		a->free(a->ctx, p, sz);
+}
+
+#endif
@@ -0,0 +1,157 @@
+#include <stddef.h>  /* size_t, NULL, max_align_t, offsetof() */
+#include <stdbool.h> /* bool, true, false                     */
+#include <string.h>  /* memcpy()                              */
+#include "arena.h"
+
+/* Edit the below to allocate chunks with a custom allocator */
+#include <stdlib.h>
+static void *(*const arena_realloc_)(void *, size_t) = realloc;
+static void  (*const arena_free_)   (void *)         = free;
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+enum { DEFAULT_CHUNKSZ = 64 * 1024 };
+
+#if __STDC_VERSION__ < 201112L
+typedef union {
+	long double f; long long i;
+	void *p; void (*fp)(void);
+} maxalign;
+#else
+typedef max_align_t maxalign;
+#endif
+
+/* Header preceeding each chunk's blocks.
+ * Aligned such that a block right after it casts to any T * .
+ */
+typedef struct chunk {
+	struct chunk *prev;
+	size_t size; /* Bytes available after the header */
+	maxalign _align[];
+} chunk;
+
+/* Blocks are aligned to ALIGN, so they cast to any T * too */
+struct alignprobe { char c; maxalign m; };
+enum {
+	CHUNKSZ = sizeof(chunk),
+	ALIGN = offsetof(struct alignprobe, m)
+};
+
+typedef unsigned char byte;
+
+struct arena {
+	chunk *cur;       /* Chunk being allocated from, latest of list  */
+	byte *top, *end;  /* Free space of cur                           */
+	byte *last;       /* Latest block, if it is still allocated      */
+	size_t chunksz;
+	darc_allocator alloc;
+};
+
+/* Rounds n up to a non-zero multiple of ALIGN, or returns 0 on overflow.
+ * Blocks are never empty, so that no two share an address.
+ */
+static inline size_t alignup(size_t n)
+{
+	return n > SIZE_MAX-ALIGN ? 0 : n ? (n+ALIGN-1) / ALIGN * ALIGN : ALIGN;
+}
+
+static inline byte *data(chunk *c) { return (byte *)(c+1); }
+
+/* Makes a new chunk with room for at least n bytes current */
+static bool newchunk(arena *a, size_t n)
+{
+	size_t size = n > a->chunksz ? n : a->chunksz;
+	chunk *c;
+	if (size > SIZE_MAX-CHUNKSZ || !(c = arena_realloc_(NULL, CHUNKSZ+size)))
+		return false;
+
+	*c = (chunk){.prev = a->cur, .size = size};
+	a->cur = c, a->top = data(c), a->end = data(c) + size;
+	return true;
+}
+
+/* Bumps out n bytes */
+static void *bump(arena *a, size_t n)
+{
+	if ((size_t)(a->end - a->top) < n && !newchunk(a, n))
+		return NULL;
+	a->last = a->top, a->top += n;
+	return a->last;
+}
+
+static void *arena_grow(void *ctx, void *p, size_t oldsz, size_t newsz)
+{
+	arena *a = ctx;
+	size_t n = alignup(newsz);
+	if (!n)
+		return NULL;
+
+	if (p && p == a->last) { /* Latest block, try in place */
+		if (n <= (size_t)(a->end - (byte *)p)) {
+			a->top = (byte *)p + n;
+			return p;
+		} else if (p == data(a->cur)) { /* Alone in its chunk */
+			chunk *c;
+			if (n > SIZE_MAX-CHUNKSZ
+			   || !(c = arena_realloc_(a->cur, CHUNKSZ+n)))
+				return NULL;
+			c->size = n;
+			a->cur = c, a->top = a->end = data(c) + n;
+			return a->last = data(c);
+		}
+	} else if (p && newsz <= oldsz) /* Shrinking, nothing to reclaim */
+		return p;
+
+	byte *q = bump(a, n);
+	if (q && p)
+		memcpy(q, p, oldsz < newsz ? oldsz : newsz);
+	return q;
+}
+
+static void arena_release(void *ctx, void *p, size_t sz)
+{
+	arena *a = ctx;
+	(void)sz;
+	if (p && p == a->last) /* Latest block, reclaim its space */
+		a->top = a->last, a->last = NULL;
+}
+
+arena *arena_create(size_t chunksz)
+{
+	arena *a = arena_realloc_(NULL, sizeof *a);
+	if (a) {
+		*a = (arena){.chunksz = chunksz ? chunksz : DEFAULT_CHUNKSZ};
+		a->alloc = (darc_allocator){arena_grow, arena_release, a};
+	}
+	return a;
+}
+
+/* Frees every chunk from c backwards */
+static void freechunks(chunk *c)
+{
+	while (c) {
+		chunk *prev = c->prev;
+		arena_free_(c), c = prev;
+	}
+}
+
+void arena_destroy(arena *a)
+{
+	if (a)
+		freechunks(a->cur), arena_free_(a);
+}
+
+void arena_reset(arena *a)
+{
+	if (a && a->cur) {
+		freechunks(a->cur->prev), a->cur->prev = NULL;
+		a->top = data(a->cur), a->last = NULL;
+	}
+}
+
+const darc_allocator *arena_allocator(arena *a)
+{
+	return a ? &a->alloc : NULL;
+}
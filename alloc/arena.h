@@ -0,0 +1,44 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h> /* size_t */
+
+#include "allocator.h" /* darc_allocator */
+
+/* A bump allocator for short-lived arrays, such as those of one request.
+ *
+ * Blocks are carved out of large chunks by bumping a pointer, and are
+ * all released at once by arena_destroy() or arena_reset(); freeing one
+ * only reclaims its space if it was the latest allocation.
+ *
+ * It is tuned to how darc grows arrays : if the block being grown is the
+ * latest allocation, it is extended in place without copying, as long as
+ * its chunk has room, or if it is alone in its chunk.
+ *
+ * Point arrays at it with create_with(..., arena_allocator(a)), e.g.
+ *   arena *a = arena_create(0);
+ *   str s = str_create_with(0, arena_allocator(a));
+ *   ...
+ *   arena_destroy(a); // Frees s and every other array in a.
+ *
+ * Not thread-safe; use an arena per thread or per request.
+ */
+typedef struct arena arena;
+
+/* Returns a new arena allocating chunks of at least chunksz bytes,
+ * or some default if chunksz is 0. Returns NULL on failure.
+ */
+arena *arena_create(size_t chunksz);
+
+/* Frees a and every block allocated from it */
+void arena_destroy(arena *a);
+
+/* Frees every block allocated from a, but keeps a's latest chunk
+ * to allocate from anew.
+ */
+void arena_reset(arena *a);
+
+/* Returns an allocator for a, which lives as long as a does */
+const darc_allocator *arena_allocator(arena *a);
+
+#endif
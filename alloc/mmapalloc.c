@@ -0,0 +1,111 @@
+#if defined __linux__ && !defined _GNU_SOURCE
+#define _GNU_SOURCE /* mremap(), MREMAP_MAYMOVE */
+#endif
+
+#include <stddef.h>   /* size_t, NULL, max_align_t */
+#include <stdlib.h>   /* malloc(), realloc(), free() */
+#include <string.h>   /* memcpy()                    */
+#include <unistd.h>   /* sysconf(), _SC_PAGESIZE     */
+#include <sys/mman.h> /* mmap(), munmap(), mremap()  */
+#include "mmapalloc.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+#if !defined MAP_ANONYMOUS && defined MAP_ANON
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* Bookkeeping preceeding caller's block.
+ * Aligned such that blk * casts to any T * .
+ */
+typedef struct blk {
+	size_t mapsz; /* Size of mapping, or 0 if malloc()'d */
+	size_t sz;    /* Size requested by caller            */
+
+	#if __STDC_VERSION__ < 201112L
+	union {
+		long double f; long long i;
+		void *p; void (*fp)(void);
+	} _align[];
+	#else
+	max_align_t _align[];
+	#endif
+} blk;
+enum { BLKSZ = sizeof(blk) };
+
+/* Rounds n up to a multiple of the page size, or returns 0 on overflow.
+ * Asks for the page size every time, not caching it in a static that
+ * threads would race to set, as it is only reached for mmap()'d blocks.
+ */
+static size_t pageround(size_t n)
+{
+	long sz = sysconf(_SC_PAGESIZE);
+	size_t pgsz = sz > 0 ? (size_t)sz : 4096;
+	return n > SIZE_MAX-pgsz ? 0 : (n+pgsz-1) / pgsz * pgsz;
+}
+
+static blk *map(size_t mapsz)
+{
+	void *p = mmap(NULL, mapsz, PROT_READ|PROT_WRITE,
+			MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	return p == MAP_FAILED ? NULL : p;
+}
+
+/* Resizes mapping b to mapsz bytes, preserving contents */
+static blk *remap(blk *b, size_t mapsz)
+{
+	#ifdef __linux__
+	void *p = mremap(b, b->mapsz, mapsz, MREMAP_MAYMOVE);
+	return p == MAP_FAILED ? NULL : p;
+	#else
+	if (mapsz < b->mapsz) {
+		munmap((unsigned char *)b + mapsz, b->mapsz - mapsz);
+		return b;
+	}
+	blk *new = map(mapsz);
+	if (new)
+		memcpy(new, b, BLKSZ + b->sz), munmap(b, b->mapsz);
+	return new;
+	#endif
+}
+
+void *mmapalloc_realloc(void *p, size_t n)
+{
+	if (n > SIZE_MAX-BLKSZ)
+		return NULL;
+
+	blk *b = p ? (blk *)p - 1 : NULL;
+	size_t mapsz = 0;
+
+	if (b && b->mapsz) { /* Already mapped, stay mapped */
+		if (!(mapsz = pageround(BLKSZ+n)))
+			return NULL;
+		if (mapsz != b->mapsz && !(b = remap(b, mapsz)))
+			return NULL;
+	} else if (BLKSZ+n < MMAPALLOC_THRESHOLD) {
+		if (!(b = realloc(b, BLKSZ+n)))
+			return NULL;
+	} else { /* Crossing threshold, copy out of malloc()'d block once */
+		blk *new;
+		if (!(mapsz = pageround(BLKSZ+n)) || !(new = map(mapsz)))
+			return NULL;
+		if (b)
+			memcpy(new+1, b+1, b->sz), free(b);
+		b = new;
+	}
+	b->mapsz = mapsz, b->sz = n;
+	return b+1;
+}
+
+void mmapalloc_free(void *p)
+{
+	if (p) {
+		blk *b = (blk *)p - 1;
+		if (b->mapsz)
+			munmap(b, b->mapsz);
+		else
+			free(b);
+	}
+}
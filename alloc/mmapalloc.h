@@ -0,0 +1,32 @@
+#ifndef MMAPALLOC_H
+#define MMAPALLOC_H
+
+#include <stddef.h> /* size_t */
+
+/* A realloc()/free() pair for very large arrays.
+ *
+ * Blocks smaller than MMAPALLOC_THRESHOLD bytes come from stdlib malloc.
+ * Larger blocks are anonymous mmap()'d mappings, which are grown or shrunk
+ * with mremap(MREMAP_MAYMOVE) on Linux, so that the kernel remaps pages
+ * instead of copying them and peak memory does not double on growth.
+ * Elsewhere, mappings are grown by mapping anew and copying.
+ *
+ * Opt in by passing these wherever darc takes an allocator :
+ * - MGA_DEF(scope, name, mmapalloc_realloc, mmapalloc_free), and similar.
+ * - Compiling vpa.c with VPA_MMAPALLOC or fpa.c with FPA_MMAPALLOC defined.
+ *
+ * Blocks must only be passed to the functions here, never to stdlib's.
+ */
+
+/* Size in bytes above which blocks are mapped, settable at compile time */
+#ifndef MMAPALLOC_THRESHOLD
+#define MMAPALLOC_THRESHOLD ((size_t)32 << 20)
+#endif
+
+/* Follows stdlib realloc's ABI. realloc(p, 0) returns a valid empty block. */
+void *mmapalloc_realloc(void *p, size_t n);
+
+/* Follows stdlib free's ABI */
+void mmapalloc_free(void *p);
+
+#endif
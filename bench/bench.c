@@ -0,0 +1,385 @@
+/* Cross-implementation benchmark for darc.
+ *
+ * Runs every member of the collection through the same workloads,
+ * over several element sizes and load levels (array lengths).
+ * Operations are timed in batches with a monotonic clock, and each
+ * (implementation, workload, element size, load) case runs in its own
+ * child process so that its peak RSS is reported in isolation.
+ *
+ * Build from the repository root with, for example :
+ *   cc -O2 -o darcbench bench/bench.c vpa/vpa.c fpa/fpa.c
+ *
+ * Usage : darcbench [-r reps] [-o out.csv] [-i impl] [-w workload] [load...]
+ * - reps is the number of repetitions per case (default 3).
+ * - impl/workload restrict the run to names containing the given string.
+ * - loads default to 1000 100000 1000000.
+ *
+ * Output is CSV with a header row and one row per case :
+ *   impl,workload,elsz,load,ops,ns_per_op,median_ns,p99_ns,peak_rss_kib
+ * where ns_per_op is the mean over all timed operations, and median_ns,
+ * p99_ns are percentiles of the per-batch ns/op samples.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>     /* printf(), fprintf(), fopen(), fflush()  */
+#include <stdlib.h>    /* realloc(), free(), qsort(), strtoul()   */
+#include <string.h>    /* memset(), strstr()                      */
+#include <stdint.h>    /* uint64_t                                */
+#include <time.h>      /* clock_gettime(), CLOCK_MONOTONIC        */
+#include <unistd.h>    /* fork(), getopt(), _exit()               */
+#include <sys/wait.h>  /* waitpid()                               */
+#include <sys/resource.h> /* getrusage(), RUSAGE_SELF             */
+
+#include "../mga/mga.h"
+#include "../vpa/tbvpa.h"
+#include "../fpa/fpa.h"
+#include "../sbomga/sbomga.h"
+#include "../stkmga/stkmga.h"
+#include "../gba/gba.h"
+#include "../sga/sga.h"
+#include "../rga/rga.h"
+#include "../tva/tva.h"
+
+/* Element types of each benchmarked size */
+#define EL(n) typedef struct el##n { unsigned char b[n]; } el##n;
+EL(1) EL(4) EL(8) EL(16) EL(64)
+
+enum {
+	NSAMPLES  = 100,      /* Timed batches per repetition              */
+	QOPS_MAX  = 1024,     /* Max ops for workloads that shift the tail */
+	QOPS_MIN  = 16,       /* Min ops for the same                      */
+	CHUNK     = 16,       /* Elements per bulk remove / churn step     */
+	STRLEN    = 24,       /* Elements appended per small-string life   */
+	STK_LIMIT = 2 << 20   /* Max stack bytes an stkmga case may use    */
+};
+/* Bytes we allow tail-shifting workloads to move per repetition */
+static const double QBYTES = 1.0 * (1 << 30);
+
+/* ---- Timing and sample collection ---- */
+
+typedef struct smp {
+	double *ns; /* ns/op of each batch */
+	size_t n, cap;
+	double total_ns, ops;
+} smp;
+
+static void die(const char *what)
+{
+	fprintf(stderr, "darcbench: %s\n", what);
+	_exit(EXIT_FAILURE);
+}
+
+static inline uint64_t now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec*1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void record(smp *s, uint64_t ns, size_t ops)
+{
+	if (s->n == s->cap) {
+		size_t cap = s->cap ? 2*s->cap : 256;
+		double *p = realloc(s->ns, cap * sizeof *p);
+		if (!p)
+			die("out of memory");
+		s->ns = p, s->cap = cap;
+	}
+	s->ns[s->n++] = (double)ns / ops;
+	s->total_ns += ns, s->ops += ops;
+}
+
+/* Runs the statements in "..." q times, timing them in batches */
+#define TIMED(s, q, ...) do {                                              \
+	size_t q_ = (q), b_ = q_/NSAMPLES ? q_/NSAMPLES : 1;               \
+	for (size_t done_ = 0; done_ < q_; ) {                             \
+		size_t k_ = q_-done_ < b_ ? q_-done_ : b_;                 \
+		uint64_t t0_ = now();                                      \
+		for (size_t j_ = 0; j_ < k_; j_++) { __VA_ARGS__ }         \
+		record(s, now()-t0_, k_);                                  \
+		done_ += k_;                                               \
+	}                                                                  \
+} while (0)
+
+/* Number of ops for workloads that shift the tail of a load-long array */
+static size_t qops(size_t load, size_t elsz)
+{
+	double q = QBYTES / ((double)load*elsz + 1);
+	return q < QOPS_MIN ? QOPS_MIN : q > QOPS_MAX ? QOPS_MAX : (size_t)q;
+}
+
+/* Source elements for every insertion */
+static unsigned char srcbuf[CHUNK * 64 > STRLEN * 64 ? CHUNK*64 : STRLEN*64];
+
+/* ---- Adapters giving every implementation the same statements ----
+ *
+ * "t" is an instantiation name and "v" a local variable name.
+ * All other arguments must be free of side effects.
+ */
+
+/* mga, vpa (through tbvpa), sbomga, gba, sga, rga and tva share one
+ * interface
+ */
+#define A_mga_NEW(t, v)           t v = t##_create(0)
+#define A_mga_LEN(t, v)           ((v).len)
+#define A_mga_INS(t, v, i, s, n)  if (!t##_insert(&(v), i, s, n)) die(#t)
+#define A_mga_SELF(t, v, d, s, n) if (!t##_selfinsert(&(v), d, s, n)) die(#t)
+#define A_mga_REM(t, v, i, n)     if (!t##_remove(&(v), i, n)) die(#t)
+#define A_mga_SHRINK(t, v)        t##_shrink_to_fit(&(v))
+#define A_mga_FREE(t, v)          t##_destroy(&(v))
+
+#define A_fpa_NEW(t, v)           t##_eltype *v = fpa_create(0, sizeof *v)
+#define A_fpa_LEN(t, v)           (*fpa_len(v))
+#define A_fpa_INS(t, v, i, s, n)  if (!fpa_insert(&(v), i, s, n)) die(#t)
+#define A_fpa_SELF(t, v, d, s, n) if (!fpa_selfinsert(&(v), d, s, n)) die(#t)
+#define A_fpa_REM(t, v, i, n)     if (!fpa_remove(v, i, n)) die(#t)
+#define A_fpa_SHRINK(t, v)        fpa_shrink_to_fit(&(v))
+#define A_fpa_FREE(t, v)          fpa_destroy(&(v))
+
+#define A_stk_NEW(t, v)           t v = STKMGA_CREATE(t, 0)
+#define A_stk_LEN(t, v)           ((v).len)
+#define A_stk_INS(t, v, i, s, n)  \
+	{ int ok_ = 1; size_t i_ = (i); /* A literal i trips -Wtype-limits */ \
+	  STKMGA_INSERT(t, v, i_, s, n, ok_); if (!ok_) die(#t); }
+#define A_stk_SELF(t, v, d, s, n) \
+	{ int ok_ = 1; STKMGA_SELFINSERT(t, v, d, s, n, ok_); if (!ok_) die(#t); }
+#define A_stk_REM(t, v, i, n)     \
+	{ int ok_ = 1; STKMGA_REMOVE(t, v, i, n, ok_); if (!ok_) die(#t); }
+#define A_stk_SHRINK(t, v)        ((void)0)
+#define A_stk_FREE(t, v)          ((void)0)
+
+/* ---- Workloads ---- */
+
+enum { W_APPEND, W_FRONT, W_MIDDLE, W_SELF, W_REMOVE, W_SHRINK, W_STRING,
+       W_COUNT };
+static const char *const wlnames[W_COUNT] = {
+	"append", "front_insert", "middle_insert", "selfinsert",
+	"bulk_remove", "shrink_churn", "string_life"
+};
+
+/* Generates t_life(), one small-string lifecycle, and t_run(),
+ * which runs workload wl once on a load-long array of t
+ * using adapters A_K_*.
+ *
+ * Every case is in a function of its own so that stkmga's
+ * alloca()'d blocks are released when it returns.
+ */
+#define WORKLOADS(K, t)                                                    \
+static __attribute__((noinline)) void t##_life(void)                       \
+{                                                                          \
+	const t##_eltype *src = (const void *)srcbuf;                      \
+	A_##K##_NEW(t, v);                                                 \
+	for (size_t k = 0; k < STRLEN; k += STRLEN/3) {                    \
+		size_t at = A_##K##_LEN(t, v);                             \
+		A_##K##_INS(t, v, at, src, STRLEN/3);                      \
+	}                                                                  \
+	A_##K##_FREE(t, v);                                                \
+}                                                                          \
+									   \
+static __attribute__((noinline)) void t##_run(int wl, size_t load, smp *s) \
+{                                                                          \
+	const t##_eltype *src = (const void *)srcbuf;                      \
+	size_t q = qops(load, sizeof(t##_eltype));                         \
+									   \
+	if (wl == W_STRING) {                                              \
+		TIMED(s, load, t##_life(); );                              \
+		return;                                                    \
+	}                                                                  \
+	A_##K##_NEW(t, v);                                                 \
+	if (wl == W_APPEND) {                                              \
+		TIMED(s, load,                                             \
+			size_t at = A_##K##_LEN(t, v);                     \
+			A_##K##_INS(t, v, at, src, 1);                     \
+		);                                                         \
+		A_##K##_FREE(t, v);                                        \
+		return;                                                    \
+	}                                                                  \
+	/* Every other workload works on a prefilled array */              \
+	size_t extra = wl == W_REMOVE ? q*CHUNK : 0;                       \
+	for (size_t k = 0; k < load+extra; k++) {                          \
+		size_t at = A_##K##_LEN(t, v);                             \
+		A_##K##_INS(t, v, at, src, 1);                             \
+	}                                                                  \
+	switch (wl) {                                                      \
+	case W_FRONT:                                                      \
+		TIMED(s, q, A_##K##_INS(t, v, 0, src, 1); );               \
+		break;                                                     \
+	case W_MIDDLE:                                                     \
+		TIMED(s, q,                                                \
+			size_t at = A_##K##_LEN(t, v)/2;                   \
+			A_##K##_INS(t, v, at, src, 1);                     \
+		);                                                         \
+		break;                                                     \
+	case W_SELF:                                                       \
+		TIMED(s, q,                                                \
+			size_t len = A_##K##_LEN(t, v);                    \
+			size_t at = len/2, from = len/4;                   \
+			A_##K##_SELF(t, v, at, from, 1);                   \
+		);                                                         \
+		break;                                                     \
+	case W_REMOVE:                                                     \
+		TIMED(s, q,                                                \
+			size_t at = A_##K##_LEN(t, v)/2;                   \
+			A_##K##_REM(t, v, at, CHUNK);                      \
+		);                                                         \
+		break;                                                     \
+	case W_SHRINK:                                                     \
+		TIMED(s, q,                                                \
+			size_t at = A_##K##_LEN(t, v);                     \
+			A_##K##_INS(t, v, at, src, CHUNK);                 \
+			A_##K##_REM(t, v, at, CHUNK);                      \
+			A_##K##_SHRINK(t, v);                              \
+		);                                                         \
+		break;                                                     \
+	}                                                                  \
+	A_##K##_FREE(t, v);                                                \
+}
+
+/* Instantiates every implementation for element size n */
+#define INSTANTIATE(n)                                                     \
+	MGA_IMPL(mga_el##n, realloc, free, el##n)                          \
+	WORKLOADS(mga, mga_el##n)                                          \
+	TBVPA_GEN(vpa_el##n, el##n)                                        \
+	WORKLOADS(mga, vpa_el##n)                                          \
+	typedef el##n fpa_el##n##_eltype;                                  \
+	WORKLOADS(fpa, fpa_el##n)                                          \
+	SBOMGA_IMPL(sbomga_el##n, realloc, free, 0, el##n)                 \
+	WORKLOADS(mga, sbomga_el##n)                                       \
+	STKMGA_DECL(stkmga_el##n, el##n)                                   \
+	WORKLOADS(stk, stkmga_el##n)                                       \
+	GBA_IMPL(gba_el##n, realloc, free, el##n)                          \
+	WORKLOADS(mga, gba_el##n)                                          \
+	SGA_IMPL(sga_el##n, realloc, free, el##n)                          \
+	WORKLOADS(mga, sga_el##n)                                          \
+	RGA_IMPL(rga_el##n, realloc, free, el##n)                          \
+	WORKLOADS(mga, rga_el##n)                                          \
+	TVA_IMPL(tva_el##n, realloc, free, el##n)                          \
+	WORKLOADS(mga, tva_el##n)
+
+INSTANTIATE(1) INSTANTIATE(4) INSTANTIATE(8) INSTANTIATE(16) INSTANTIATE(64)
+
+typedef void runfn(int wl, size_t load, smp *s);
+
+enum { NIMPLS = 9 };
+static const char *const implnames[NIMPLS] = {
+	"mga", "vpa", "fpa", "sbomga", "stkmga", "gba", "sga",
+	"rga", "tva"
+};
+
+#define ROW(n) { n, {                                                      \
+	mga_el##n##_run, vpa_el##n##_run, fpa_el##n##_run,                 \
+	sbomga_el##n##_run, stkmga_el##n##_run, gba_el##n##_run,           \
+	sga_el##n##_run, rga_el##n##_run, tva_el##n##_run                  \
+} }
+static const struct { size_t elsz; runfn *run[NIMPLS]; } cases[] = {
+	ROW(1), ROW(4), ROW(8), ROW(16), ROW(64)
+};
+
+/* ---- Driver ---- */
+
+static int cmpdbl(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile p of sorted samples */
+static double pct(const smp *s, double p)
+{
+	size_t k = (size_t)(p/100 * s->n + 0.5);
+	return s->ns[k ? (k <= s->n ? k-1 : s->n-1) : 0];
+}
+
+/* Returns whether impl should be skipped for a load of elsz-sized elements */
+static bool skip(int impl, int wl, size_t elsz, size_t load)
+{
+	if (wl == W_STRING && elsz != 1)
+		return true;
+	/* stkmga keeps every block it outgrew till its function returns */
+	size_t q = qops(load, elsz), n = load + (wl == W_REMOVE ? q*CHUNK : q);
+	return impl == 4 && wl != W_STRING && n*elsz*4 > STK_LIMIT;
+}
+
+static void runcase(FILE *out, int impl, int wl, size_t elsz, runfn *run,
+		size_t load, unsigned reps)
+{
+	smp s = {0};
+	for (unsigned r = 0; r < reps; r++)
+		run(wl, load, &s);
+	qsort(s.ns, s.n, sizeof *s.ns, cmpdbl);
+
+	struct rusage ru;
+	getrusage(RUSAGE_SELF, &ru);
+	fprintf(out, "%s,%s,%zu,%zu,%.0f,%.3f,%.3f,%.3f,%ld\n",
+		implnames[impl], wlnames[wl], elsz, load, s.ops / reps,
+		s.total_ns / s.ops, pct(&s, 50), pct(&s, 99), ru.ru_maxrss);
+	fflush(out);
+	free(s.ns);
+}
+
+int main(int argc, char **argv)
+{
+	FILE *out = stdout;
+	const char *ifilter = "", *wfilter = "";
+	unsigned reps = 3;
+
+	for (int c; (c = getopt(argc, argv, "r:o:i:w:")) != -1; ) {
+		switch (c) {
+		case 'r':
+			if (!(reps = strtoul(optarg, NULL, 0)))
+				die("invalid repetition count");
+			break;
+		case 'o':
+			if (!(out = fopen(optarg, "w")))
+				die("cannot open output file");
+			break;
+		case 'i': ifilter = optarg; break;
+		case 'w': wfilter = optarg; break;
+		default:
+			fputs("Usage : darcbench [-r reps] [-o out.csv] "
+			      "[-i impl] [-w workload] [load...]\n", stderr);
+			return EXIT_FAILURE;
+		}
+	}
+
+	size_t defloads[] = {1000, 100000, 1000000}, nloads = argc-optind;
+	size_t *loads = nloads ? calloc(nloads, sizeof *loads) : defloads;
+	if (!loads)
+		die("out of memory");
+	for (size_t k = 0; k < nloads; k++)
+		if (!(loads[k] = strtoul(argv[optind+k], NULL, 0)))
+			die("invalid load");
+	if (!nloads)
+		nloads = sizeof defloads / sizeof *defloads;
+
+	fputs("impl,workload,elsz,load,ops,ns_per_op,median_ns,p99_ns,"
+	      "peak_rss_kib\n", out);
+	fflush(out);
+
+	for (size_t l = 0; l < nloads; l++)
+	for (int wl = 0; wl < W_COUNT; wl++)
+	for (size_t e = 0; e < sizeof cases / sizeof *cases; e++)
+	for (int impl = 0; impl < NIMPLS; impl++) {
+		if (!strstr(implnames[impl], ifilter)
+		   || !strstr(wlnames[wl], wfilter)
+		   || skip(impl, wl, cases[e].elsz, loads[l]))
+			continue;
+
+		pid_t pid = fork();
+		if (pid == 0) {
+			runcase(out, impl, wl, cases[e].elsz,
+				cases[e].run[impl], loads[l], reps);
+			_exit(EXIT_SUCCESS);
+		}
+		int st;
+		if (pid < 0 || waitpid(pid, &st, 0) < 0 || !WIFEXITED(st)
+		   || WEXITSTATUS(st) != EXIT_SUCCESS)
+			fprintf(stderr, "darcbench: %s/%s/%zu/%zu failed\n",
+				implnames[impl], wlnames[wl],
+				cases[e].elsz, loads[l]);
+	}
+
+	if (loads != defloads)
+		free(loads);
+	return out == stdout || !fclose(out) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
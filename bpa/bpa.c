@@ -0,0 +1,306 @@
+#include <string.h> /* memmove(), memset() */
+#include "bpa.h"
+
+/* Edit the below to use a custom allocator */
+#include <stdlib.h>
+static void *(*const bpa_realloc)(void *, size_t) = realloc;
+static void  (*const bpa_free)   (void *)         = free;
+
+enum { W = BPA_WORDBITS };
+
+#if defined __GNUC__
+#define popcount(w) ((size_t)__builtin_popcountll(w))
+#define ctz(w) ((size_t)__builtin_ctzll(w))
+#else
+static inline size_t popcount(bpa_word w)
+{
+	/* Sum bits in pairs, then nibbles, then bytes */
+	w -= w >> 1 & 0x5555555555555555;
+	w = (w & 0x3333333333333333) + (w >> 2 & 0x3333333333333333);
+	w = (w + (w >> 4)) & 0x0f0f0f0f0f0f0f0f;
+	return (w * 0x0101010101010101) >> 56;
+}
+static inline size_t ctz(bpa_word w) /* w != 0 */
+{
+	register size_t n = 0;
+	for (; !(w & 1); w >>= 1)
+		n++;
+	return n;
+}
+#endif
+
+/* Marks loops shifting words as safe to vectorize, see bitmove() */
+#if defined __clang__
+#define ivdep _Pragma("clang loop vectorize(assume_safety)")
+#elif defined __GNUC__
+#define ivdep _Pragma("GCC ivdep")
+#else
+#define ivdep
+#endif
+
+/* Words holding n bits */
+static inline size_t words(size_t n) { return n/W + (n%W != 0); }
+
+/* Mask of the low k <= W bits */
+static inline bpa_word low(size_t k)
+{
+	return k < W ? ((bpa_word)1 << k) - 1 : ~(bpa_word)0;
+}
+
+/* Returns k <= W bits of a from bit s, reading no word past them */
+static inline bpa_word getbits(const bpa_word *a, size_t s, size_t k)
+{
+	register size_t b = s%W;
+	register bpa_word v = a[s/W] >> b;
+	if (b+k > W)
+		v |= a[s/W+1] << (W-b);
+	return v & low(k);
+}
+
+/* Writes the k <= W bits of v, which has no others, to a from bit d */
+static inline void setbits(bpa_word *a, size_t d, size_t k, bpa_word v)
+{
+	register size_t b = d%W;
+	register bpa_word m = low(k);
+	a[d/W] = (a[d/W] & ~(m << b)) | v << b;
+	if (b+k > W)
+		a[d/W+1] = (a[d/W+1] & ~(m >> (W-b))) | v >> (W-b);
+}
+
+/* Copies n bits of src from bit s to dst from bit d, as memmove() does
+ * if dst == src. Bits up to a word boundary of dst are copied one by one,
+ * then whole words, each from the two source words it straddles,
+ * or by memmove() when s and d are whole words apart.
+ *
+ * Word loops run away from the side the bits move to, so each reads
+ * words before they are written over, even a vector of them at a time.
+ */
+static void bitmove(bpa_word *dst, size_t d, const bpa_word *src, size_t s,
+		size_t n)
+{
+	register size_t k, b, nw;
+	if (!n || (dst == src && d == s))
+		return;
+
+	if (dst != src || d < s) { /* Front to back */
+		if (d%W) {
+			k = W-d%W < n ? W-d%W : n;
+			setbits(dst, d, k, getbits(src, s, k));
+			d += k, s += k, n -= k;
+		}
+		bpa_word *to = dst + d/W;
+		const bpa_word *from = src + s/W;
+		b = s%W, nw = n/W;
+
+		if (!b)
+			memmove(to, from, nw*sizeof *to);
+		else
+			ivdep for (size_t j = 0; j < nw; j++)
+				to[j] = from[j] >> b | from[j+1] << (W-b);
+		d += nw*W, s += nw*W, n -= nw*W;
+	} else { /* Back to front */
+		if ((d+n)%W) {
+			k = (d+n)%W < n ? (d+n)%W : n;
+			setbits(dst, d+n-k, k, getbits(src, s+n-k, k));
+			n -= k;
+		}
+		nw = n/W, n -= nw*W;
+		bpa_word *to = dst + (d+n)/W;
+		const bpa_word *from = src + (s+n)/W;
+		b = (s+n)%W;
+
+		if (!b)
+			memmove(to, from, nw*sizeof *to);
+		else
+			ivdep for (size_t j = nw; j--; )
+				to[j] = from[j] >> b | from[j+1] << (W-b);
+	}
+	/* Bits past the last whole word, or before the first */
+	if (n)
+		setbits(dst, d, n, getbits(src, s, n));
+}
+
+/* Sets n bits of a from bit d to 0 */
+static void zero(bpa_word *a, size_t d, size_t n)
+{
+	register size_t k;
+	if (d%W && n) {
+		k = W-d%W < n ? W-d%W : n;
+		setbits(a, d, k, 0);
+		d += k, n -= k;
+	}
+	memset(a + d/W, 0, n/W*sizeof *a);
+	d += n/W*W, n %= W;
+	if (n)
+		setbits(a, d, n, 0);
+}
+
+/* Clears the bits of the last word past .len */
+static inline void trim(bpa *foo)
+{
+	if (foo->len%W)
+		foo->arr[foo->len/W] &= low(foo->len%W);
+}
+
+/* Reallocate or free .arr, with its allocator if it has one */
+static inline void *grow(const bpa *v, size_t newcap)
+{
+	return darc_realloc(v->alloc, bpa_realloc, v->arr,
+			v->cap/W*sizeof(bpa_word), newcap/W*sizeof(bpa_word));
+}
+static inline void release(const bpa *v)
+{
+	darc_free(v->alloc, bpa_free, v->arr, v->cap/W*sizeof(bpa_word));
+}
+
+bpa bpa_create_with(size_t n, const darc_allocator *alloc)
+{
+	bpa res = {.alloc = alloc};
+	if (n && n <= BPA_MAXCAP && (res.arr = grow(&res, words(n)*W)))
+		res.cap = words(n)*W;
+	return res;
+}
+
+bpa bpa_create(size_t n) { return bpa_create_with(n, NULL); }
+
+void bpa_destroy(bpa *foo)
+{
+	if (foo) {
+		release(foo), foo->arr = NULL;
+		foo->len = foo->cap = 0;
+	}
+}
+
+bool bpa_reserve(bpa *foo, size_t n)
+{
+	if (foo && n <= BPA_MAXCAP) {
+		register size_t cap = foo->cap;
+
+		if (cap < n) {
+			size_t newcap = cap+cap/2; /* Try growing 1.5x */
+			/* Or grow to n bits if its bigger or overflow */
+			if (newcap < n || newcap > BPA_MAXCAP)
+				newcap = n;
+			newcap = words(newcap)*W;
+
+			void *p = grow(foo, newcap);
+			if (p)
+				foo->arr = p, foo->cap = newcap;
+			else
+				return false;
+		}
+		return true;
+	} else
+		return false;
+}
+
+bool bpa_insert(bpa *dst, size_t i, const bpa_word *restrict src, size_t n)
+{
+	if (n == 0)
+		return true;
+
+	register size_t len;
+	if (dst && n <= BPA_MAXCAP && BPA_MAXCAP-n >= (len = dst->len)
+			&& i <= len && bpa_reserve(dst, len+n)) {
+
+		/* move bits at i to i+n to preserve them */
+		bitmove(dst->arr, i+n, dst->arr, i, len-i);
+		if (src)
+			bitmove(dst->arr, i, src, 0, n);
+		else
+			zero(dst->arr, i, n);
+
+		dst->len = len+n;
+		trim(dst);
+		return true;
+	} else
+		return false;
+}
+
+bool bpa_selfinsert(bpa *foo, size_t idst, size_t isrc, size_t n)
+{
+	if (n == 0)
+		return true;
+
+	register size_t len;
+	if (foo && n <= BPA_MAXCAP && BPA_MAXCAP-n >= (len = foo->len)
+		&& idst <= len && isrc < len && n <= len-isrc
+		&& bpa_reserve(foo, len+n)) {
+
+		bitmove(foo->arr, idst+n, foo->arr, idst, len-idst);
+		/* If idst < isrc, isrc has moved n ahead */
+		bitmove(foo->arr, idst, foo->arr, isrc + (idst < isrc)*n, n);
+
+		foo->len = len+n;
+		trim(foo);
+		return true;
+	} else
+		return false;
+}
+
+bool bpa_remove(bpa *dst, size_t i, size_t n)
+{
+	register size_t len;
+	if (dst && i <= (len = dst->len) && n <= len-i) {
+		/* Shift bits at index > i one step back */
+		bitmove(dst->arr, i, dst->arr, i+n, len-i-n);
+
+		dst->len = len-n;
+		trim(dst);
+		return true;
+	} else
+		return false;
+}
+
+void bpa_shrink_to_fit(bpa *foo)
+{
+	/* Avoid realloc() call if not needed */
+	register size_t cap;
+	if (foo && foo->cap > (cap = words(foo->len)*W)) {
+		void *p = cap ? grow(foo, cap) : (release(foo), NULL);
+		if (p || !cap)
+			foo->arr = p, foo->cap = cap;
+	}
+}
+
+size_t bpa_popcount(const bpa *foo)
+{
+	register size_t n = 0;
+	if (foo)
+		for (size_t j = 0, nw = words(foo->len); j < nw; j++)
+			n += popcount(foo->arr[j]);
+	return n;
+}
+
+size_t bpa_find_first(const bpa *foo, size_t i)
+{
+	if (!foo)
+		return 0;
+	else if (i >= foo->len)
+		return foo->len;
+
+	register size_t j = i/W, nw = words(foo->len);
+	/* Skip bits before i, the last word has none past .len */
+	register bpa_word w = foo->arr[j] & ~low(i%W);
+	while (!w && ++j < nw)
+		w = foo->arr[j];
+	return w ? j*W + ctz(w) : foo->len;
+}
+
+/* Defines bpa_fn, applying op word by word */
+#define bitwise(fn, op)                                                       \
+bool bpa_##fn(bpa *dst, const bpa *src)                                       \
+{                                                                             \
+	if (dst && src && dst->len == src->len) {                             \
+		bpa_word *d = dst->arr;                                       \
+		const bpa_word *s = src->arr;                                 \
+		for (size_t j = 0, nw = words(dst->len); j < nw; j++)         \
+			d[j] op s[j];                                         \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}
+
+bitwise(and, &=)
+bitwise(or, |=)
+bitwise(xor, ^=)
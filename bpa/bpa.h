@@ -0,0 +1,101 @@
+#ifndef BPA_H
+#define BPA_H
+
+#include <stdbool.h> /* bool               */
+#include <stddef.h>  /* size_t             */
+#include <stdint.h>  /* uint64_t, SIZE_MAX */
+
+#include "../alloc/allocator.h" /* darc_allocator */
+
+/* Bits are packed BPA_WORDBITS to a word, bit i of the array being
+ * bit i % BPA_WORDBITS (from the least significant) of word i / BPA_WORDBITS.
+ */
+typedef uint64_t bpa_word;
+#define BPA_WORDBITS 64
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+/* The largest possible capacity of a bpa, in bits */
+#define BPA_MAXCAP (SIZE_MAX & ~(size_t)(BPA_WORDBITS-1))
+
+/* arr is a buffer of len bits allocated for upto cap bits,
+ * where cap is a multiple of BPA_WORDBITS.
+ * Bits of arr's last word past len are always 0.
+ *
+ * arr is allocated with *alloc, or bpa.c's realloc/free if alloc is NULL.
+ * *alloc must outlive the bpa.
+ */
+typedef struct bpa {
+	size_t len, cap;
+	bpa_word *arr;
+	const darc_allocator *alloc;
+} bpa;
+
+/* Returns alloc'd & init'd bpa with room for n bits.
+ * If n == 0 or on error; .cap = 0, .arr = NULL.
+ */
+bpa bpa_create(size_t n);
+
+/* Like bpa_create(), but allocating with alloc */
+bpa bpa_create_with(size_t n, const darc_allocator *alloc);
+
+/* free()'s .arr & resets all fields but .alloc to 0 */
+void bpa_destroy(bpa *);
+
+/* Ensures capacity of at least n bits in .arr
+ * Returns true if successful, else false.
+ */
+bool bpa_reserve(bpa *, size_t n);
+
+/* If src != NULL, inserts n bits from src at bit i,
+ * the first being bit 0 of src[0], as packed in .arr.
+ * Else, moves bits at index >= i ahead by n, and sets the n at i to 0.
+ *
+ * UB if src overlaps with .arr
+ * Returns true if successful, else false.
+ */
+bool bpa_insert(bpa *, size_t i, const bpa_word *restrict src, size_t n);
+
+/* Inserts n bits from isrc at idst.
+ * Returns true if successful, else false.
+ */
+bool bpa_selfinsert(bpa *, size_t idst, size_t isrc, size_t n);
+
+/* Removes n bits from i onwards.
+ * Returns true on success or false on failure (out-of-bounds).
+ */
+bool bpa_remove(bpa *, size_t i, size_t n);
+
+/* Dynamic arrays overallocate for efficiency,
+ * Reallocs .arr (if not already) to the fewest words holding .len bits
+ */
+void bpa_shrink_to_fit(bpa *);
+
+/* Returns the number of set bits */
+size_t bpa_popcount(const bpa *);
+
+/* Returns the index of the first set bit at or after i, or .len if none */
+size_t bpa_find_first(const bpa *, size_t i);
+
+/* Sets dst to dst & src, dst | src, or dst ^ src, bit by bit.
+ * Returns false, changing nothing, if their .len differ.
+ */
+bool bpa_and(bpa *dst, const bpa *src);
+bool bpa_or(bpa *dst, const bpa *src);
+bool bpa_xor(bpa *dst, const bpa *src);
+
+/* Reads or writes bit i, UB if i >= .len */
+static inline bool bpa_get(const bpa *foo, size_t i)
+{
+	return foo->arr[i/BPA_WORDBITS] >> i%BPA_WORDBITS & 1;
+}
+static inline void bpa_set(bpa *foo, size_t i, bool x)
+{
+	bpa_word *w = foo->arr + i/BPA_WORDBITS;
+	bpa_word bit = (bpa_word)1 << i%BPA_WORDBITS;
+	*w = x ? *w | bit : *w & ~bit;
+}
+
+#endif
@@ -0,0 +1,464 @@
+#ifndef FLAT_H
+#define FLAT_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+
+#include "../mga/mga.h" /* MGA_DECL(), MGA_DEF() */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define FLAT_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define FLAT_UNUSED __attribute__((unused))
+#else
+	#define FLAT_UNUSED
+#endif
+
+/* Fetches the next probes of a binary search ahead of the compare */
+#if defined __GNUC__
+	#define FLAT_PREFETCH_(p) __builtin_prefetch(p)
+#else
+	#define FLAT_PREFETCH_(p) ((void)0)
+#endif
+
+enum {
+	FLAT_SCAN = 16,        /* Tail elements lookups scan, not merge   */
+	FLAT_INDEX_MIN = 1024, /* Sorted elements from which to index     */
+	FLAT_BLOCKSZ = 128     /* Bytes of sorted elements per index entry */
+};
+
+/* Declares a sorted set instantiation with given name,
+ * scope and "..." element type, stored flat in an mga.
+ *
+ * Elements v.arr[0, sorted) are unique and sorted, and followed by a tail
+ * of those inserted since, unsorted. Inserts append to the tail, which is
+ * sorted and merged in bulk once it is as long as the sorted part, or by a
+ * lookup if longer than FLAT_SCAN; so n inserts take O(n log n) time
+ * instead of the O(n^2) of keeping the array sorted on every insert.
+ * Of elements comparing equal, the last inserted is kept.
+ *
+ * Lookups binary search without branches, or if indexed, first find the
+ * block of FLAT_BLOCKSZ bytes of elements to search in an Eytzinger
+ * ordered copy of the first element of each block, whose top levels
+ * share cache lines.
+ *
+ * Where,
+ * - "scope" is empty or a valid prefix for a function declaration,
+ *   like static, inline, etc.
+ * - "name" is a valid identifier.
+ * - "..." is a type name such that a suffixed "*" creates
+ *   a pointer to that type.
+ *
+ * Example : FLATSET_DECL(, idset, unsigned)
+ * Declares idset for unsigneds with functions in the global scope.
+ *
+ * FLATMAP_DECL(scope, name, K, V) declares a sorted map of keys of type K
+ * to values of type V, as a set of name_pair {K key; V val;} compared by
+ * key, with the set's members and,
+ * - name_put(), inserts a key and value, replacing any value of the key.
+ * - name_get(), returns pointer to the value of a key, or NULL if none.
+ * - name_del(), removes a key and its value.
+ *
+ * Example : FLATMAP_DECL(static, symtab, const char *, unsigned)
+ *
+ * An instance whose v.alloc is not NULL allocates with *v.alloc
+ * instead, which must outlive the instance.
+ *
+ * - Member types :
+ *   - name_eltype, the type of the elements.
+ *   - name_mga, the MGA_DECL()'d array v.
+ *
+ * - Member functions :
+ *   - name_create()
+ *   - name_create_with(), which also sets the allocator alloc.
+ *   - name_destroy()
+ *   - name_insert(), inserts one element.
+ *   - name_insert_many(), inserts n elements.
+ *   - name_merge(), sorts and merges the tail into the sorted part,
+ *     after which v.arr[0, v.len) are all the elements, sorted.
+ *   - name_find(), returns pointer to the element equal to a given one,
+ *     or NULL if none. Valid until the set is next modified, and not to be
+ *     modified in ways that change its order.
+ *   - name_contains()
+ *   - name_lower_bound(), merges, then returns the index in v.arr of the
+ *     first element not less than a given one, or v.len if none.
+ *     If merging fails, the tail is not considered.
+ *   - name_remove(), merges, then removes the element equal to a given one.
+ *     Returns false if there is none, or merging fails.
+ *   - name_set_index(), enables or disables (and frees) the index,
+ *     disabled by default, built by lookups once there are at least
+ *     FLAT_INDEX_MIN sorted elements.
+ *   - name_shrink_to_fit()
+ */
+#define FLATSET_DECL(scope, name, ...)                                        \
+MGA_DECL(scope, name##_mga, __VA_ARGS__)                                      \
+typedef name##_mga_eltype name##_eltype;                                      \
+typedef struct name {                                                         \
+	name##_mga v;                                                         \
+	size_t sorted;                                                        \
+	/* Index : eyt[1, neyt] the Eytzinger ordered first elements of the
+	 * sorted part's blocks, rank[k] the block eyt[k] is first of.
+	 */                                                                   \
+	name##_eltype *eyt; size_t *rank, neyt;                               \
+	bool indexed, idxok;                                                  \
+} name;                                                                       \
+									      \
+scope name name##_create(size_t);                                             \
+scope name name##_create_with(size_t, const darc_allocator *alloc);           \
+scope void name##_destroy(name *);                                            \
+scope bool name##_insert(name *, const name##_eltype *x);                     \
+scope bool name##_insert_many(name *, const name##_eltype *src, size_t n);    \
+scope bool name##_merge(name *);                                              \
+scope name##_eltype *name##_find(name *, const name##_eltype *x);             \
+scope bool name##_contains(name *, const name##_eltype *x);                   \
+scope size_t name##_lower_bound(name *, const name##_eltype *x);              \
+scope bool name##_remove(name *, const name##_eltype *x);                     \
+scope void name##_set_index(name *, bool on);                                 \
+scope void name##_shrink_to_fit(name *);                                      \
+
+#define FLATMAP_DECL(scope, name, K, V)                                       \
+typedef K name##_key;                                                         \
+typedef V name##_val;                                                         \
+typedef struct name##_pair { name##_key key; name##_val val; } name##_pair;   \
+FLATSET_DECL(scope, name, name##_pair)                                        \
+scope bool name##_put(name *, const name##_key *k, const name##_val *v);      \
+scope name##_val *name##_get(name *, const name##_key *k);                    \
+scope bool name##_del(name *, const name##_key *k);                           \
+
+/* Define FLAT_NOIMPL to strip implementation code */
+#ifndef FLAT_NOIMPL
+
+#include <string.h>  /* memcpy(), memmove() */
+
+/* Expands function definitons for previously FLATSET_DECL()'d name.
+ *
+ * Where "less" is a function or function-like macro, such that
+ * less(const name_eltype *a, const name_eltype *b) is true if a is ordered
+ * before b, called directly and so can be inlined; and the rest are as
+ * for MGA_DEF().
+ *
+ * Example : #define LESS(a, b) (*(a) < *(b))
+ *           FLATSET_DEF(, idset, LESS, realloc, free)
+ */
+#define FLATSET_DEF(scope, name, less, reallocfn, freefn)                     \
+MGA_DEF(scope, name##_mga, reallocfn, freefn)                                 \
+									      \
+/* Elements per index entry */                                                \
+enum { name##_blk_ = sizeof(name##_eltype) >= FLAT_BLOCKSZ/2 ? 2              \
+	: FLAT_BLOCKSZ/sizeof(name##_eltype) };                               \
+									      \
+/* Index of the first of the n elements of sorted a not less than *x */       \
+static inline size_t name##_lb_(const name##_eltype *a, size_t n,             \
+		const name##_eltype *x)                                       \
+{                                                                             \
+	register const name##_eltype *base = a;                               \
+									      \
+	if (!n)                                                               \
+		return 0;                                                     \
+	while (n > 1) {                                                       \
+		register size_t half = n/2;                                   \
+		FLAT_PREFETCH_(base + half/2 - 1);                            \
+		FLAT_PREFETCH_(base + half + half/2 - 1);                     \
+		base += less(base+half-1, x) ? half : 0;                      \
+		n -= half;                                                    \
+	}                                                                     \
+	return base-a + less(base, x);                                        \
+}                                                                             \
+									      \
+/* Stably sorts the n elements of a, using b of as many.
+ * Returns whichever of a or b holds the result.
+ */                                                                           \
+static name##_eltype *name##_sort_(name##_eltype *a, name##_eltype *b,        \
+		size_t n)                                                     \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype), RUN = 16 };                      \
+									      \
+	/* Insertion sort runs, then merge them bottom up */                  \
+	for (size_t lo = 0; lo < n; lo += RUN) {                              \
+		register size_t hi = n-lo < RUN ? n : lo+RUN;                 \
+		for (size_t i = lo+1; i < hi; i++) {                          \
+			name##_eltype x = a[i];                               \
+			register size_t j = i;                                \
+			for (; j > lo && less(&x, a+j-1); j--)                \
+				a[j] = a[j-1];                                \
+			a[j] = x;                                             \
+		}                                                             \
+	}                                                                     \
+	for (size_t w = RUN; w < n; w *= 2) {                                 \
+		for (size_t lo = 0; lo < n; lo += 2*w) {                      \
+			register size_t mid = n-lo < w ? n : lo+w;            \
+			register size_t hi = n-mid < w ? n : mid+w;           \
+			register size_t i = lo, j = mid, k = lo;              \
+			while (i < mid && j < hi)                             \
+				b[k++] = less(a+j, a+i) ? a[j++] : a[i++];    \
+			memcpy(b+k, a+i, (mid-i)*elsz);                       \
+			memcpy(b+k+(mid-i), a+j, (hi-j)*elsz);                \
+		}                                                             \
+		register name##_eltype *t = a;                                \
+		a = b, b = t;                                                 \
+	}                                                                     \
+	return a;                                                             \
+}                                                                             \
+									      \
+/* Fills the index subtree at k from block i onwards, returns next block */   \
+static size_t name##_build_(name *foo, size_t i, size_t k)                    \
+{                                                                             \
+	if (k <= foo->neyt) {                                                 \
+		i = name##_build_(foo, i, 2*k);                               \
+		foo->eyt[k] = foo->v.arr[i*name##_blk_];                      \
+		foo->rank[k] = i++;                                           \
+		i = name##_build_(foo, i, 2*k+1);                             \
+	}                                                                     \
+	return i;                                                             \
+}                                                                             \
+									      \
+static void name##_freeindex_(name *foo)                                      \
+{                                                                             \
+	if (foo->eyt)                                                         \
+		darc_free(foo->v.alloc, name##_mga_free, foo->eyt,            \
+				(foo->neyt+1)*sizeof *foo->eyt);              \
+	if (foo->rank)                                                        \
+		darc_free(foo->v.alloc, name##_mga_free, foo->rank,           \
+				(foo->neyt+1)*sizeof *foo->rank);             \
+	foo->eyt = NULL, foo->rank = NULL, foo->neyt = 0;                     \
+	foo->idxok = false;                                                   \
+}                                                                             \
+									      \
+/* (Re)builds the index if enabled, stale, and worth it.
+ * Returns true if there is a usable index.
+ */                                                                           \
+static bool name##_index_(name *foo)                                          \
+{                                                                             \
+	if (!foo->indexed || foo->sorted < FLAT_INDEX_MIN)                    \
+		return false;                                                 \
+	if (foo->idxok)                                                       \
+		return true;                                                  \
+									      \
+	register size_t m = (foo->sorted + name##_blk_-1) / name##_blk_;      \
+	if (m != foo->neyt) {                                                 \
+		name##_eltype *eyt = darc_realloc(foo->v.alloc,               \
+				name##_mga_realloc, foo->eyt,                 \
+				foo->eyt ? (foo->neyt+1)*sizeof *eyt : 0,     \
+				(m+1)*sizeof *eyt);                           \
+		if (!eyt)                                                     \
+			return false;                                         \
+		foo->eyt = eyt;                                               \
+		size_t *rank = darc_realloc(foo->v.alloc,                     \
+				name##_mga_realloc, foo->rank,                \
+				foo->rank ? (foo->neyt+1)*sizeof *rank : 0,   \
+				(m+1)*sizeof *rank);                          \
+		if (!rank) { /* eyt is resized, so free both */               \
+			darc_free(foo->v.alloc, name##_mga_free, eyt,         \
+					(m+1)*sizeof *eyt);                   \
+			foo->eyt = NULL;                                      \
+			name##_freeindex_(foo);                               \
+			return false;                                         \
+		}                                                             \
+		foo->rank = rank, foo->neyt = m;                              \
+	}                                                                     \
+	name##_build_(foo, 0, 1);                                             \
+	return foo->idxok = true;                                             \
+}                                                                             \
+									      \
+/* Index in the sorted part of the first element not less than *x */          \
+static inline size_t name##_find_(name *foo, const name##_eltype *x)          \
+{                                                                             \
+	if (!name##_index_(foo))                                              \
+		return name##_lb_(foo->v.arr, foo->sorted, x);                \
+									      \
+	/* Descend to the first block whose first element is not less */      \
+	register size_t k = 1, m = foo->neyt;                                 \
+	while (k <= m)                                                        \
+		k = 2*k + less(foo->eyt+k, x);                                \
+	while (k & 1)                                                         \
+		k >>= 1;                                                      \
+	k >>= 1;                                                              \
+									      \
+	register size_t j = k ? foo->rank[k] : m;                             \
+	if (!j)                                                               \
+		return 0;                                                     \
+	/* So that it's in the previous block, or first of this one */        \
+	register size_t lo = (j-1)*name##_blk_;                               \
+	register size_t n = foo->sorted-lo < name##_blk_ ?                    \
+		foo->sorted-lo : name##_blk_;                                 \
+	return lo + name##_lb_(foo->v.arr+lo, n, x);                          \
+}                                                                             \
+									      \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
+{                                                                             \
+	return (name){.v = name##_mga_create_with(n, alloc)};                 \
+}                                                                             \
+									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_with(n, NULL);                                   \
+}                                                                             \
+									      \
+scope void name##_destroy(name *foo)                                          \
+{                                                                             \
+	if (foo) {                                                            \
+		name##_freeindex_(foo);                                       \
+		name##_mga_destroy(&foo->v);                                  \
+		*foo = (name){.v = foo->v, .indexed = foo->indexed};          \
+	}                                                                     \
+}                                                                             \
+									      \
+scope bool name##_merge(name *foo)                                            \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!foo)                                                             \
+		return false;                                                 \
+	register size_t s = foo->sorted, t = foo->v.len - s;                  \
+	if (!t)                                                               \
+		return true;                                                  \
+	name##_eltype *b = darc_realloc(foo->v.alloc, name##_mga_realloc,     \
+			NULL, 0, t*elsz);                                     \
+	if (!b)                                                               \
+		return false;                                                 \
+	register name##_eltype *a = foo->v.arr;                               \
+									      \
+	/* Sort the tail, and dedupe it into b keeping the last of equals */  \
+	register name##_eltype *r = name##_sort_(a+s, b, t);                  \
+	register size_t nb = 0;                                               \
+	for (size_t i = 0; i < t; i++)                                        \
+		if (i+1 == t || less(r+i, r+i+1))                             \
+			b[nb++] = r[i];                                       \
+									      \
+	/* Merge from the back, where the tail was, replacing equals */       \
+	register size_t i = s, j = nb, k = s+nb;                              \
+	while (j)                                                             \
+		if (i && less(b+j-1, a+i-1))                                  \
+			a[--k] = a[--i];                                      \
+		else {                                                        \
+			if (i && !less(a+i-1, b+j-1))                         \
+				i--;                                          \
+			a[--k] = b[--j];                                      \
+		}                                                             \
+	/* Close the gap left by replaced equals */                           \
+	memmove(a+i, a+k, (s+nb-k)*elsz);                                     \
+	foo->v.len = foo->sorted = i + s+nb-k;                                \
+	foo->idxok = false;                                                   \
+									      \
+	darc_free(foo->v.alloc, name##_mga_free, b, t*elsz);                  \
+	return true;                                                          \
+}                                                                             \
+									      \
+scope bool name##_insert_many(name *foo, const name##_eltype *src, size_t n)  \
+{                                                                             \
+	if (foo && name##_mga_insert(&foo->v, foo->v.len, src, n)) {          \
+		register size_t t = foo->v.len - foo->sorted;                 \
+		if (t > FLAT_SCAN && t >= foo->sorted)                        \
+			name##_merge(foo); /* Else stays in the tail */       \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_insert(name *foo, const name##_eltype *x)                   \
+{                                                                             \
+	return name##_insert_many(foo, x, 1);                                 \
+}                                                                             \
+									      \
+scope name##_eltype *name##_find(name *foo, const name##_eltype *x)           \
+{                                                                             \
+	if (!foo)                                                             \
+		return NULL;                                                  \
+	if (foo->v.len - foo->sorted > FLAT_SCAN)                             \
+		name##_merge(foo);                                            \
+									      \
+	/* The tail is newer, and the latest there is the latest */           \
+	register name##_eltype *a = foo->v.arr;                               \
+	for (size_t i = foo->v.len; i > foo->sorted; i--)                     \
+		if (!less(a+i-1, x) && !less(x, a+i-1))                       \
+			return a+i-1;                                         \
+	register size_t i = name##_find_(foo, x);                             \
+	return i < foo->sorted && !less(x, a+i) ? a+i : NULL;                 \
+}                                                                             \
+									      \
+scope bool name##_contains(name *foo, const name##_eltype *x)                 \
+{                                                                             \
+	return name##_find(foo, x) != NULL;                                   \
+}                                                                             \
+									      \
+scope size_t name##_lower_bound(name *foo, const name##_eltype *x)            \
+{                                                                             \
+	if (!foo)                                                             \
+		return 0;                                                     \
+	name##_merge(foo);                                                    \
+	return name##_find_(foo, x);                                          \
+}                                                                             \
+									      \
+scope bool name##_remove(name *foo, const name##_eltype *x)                   \
+{                                                                             \
+	if (!name##_merge(foo))                                               \
+		return false;                                                 \
+	register size_t i = name##_find_(foo, x);                             \
+	if (i < foo->sorted && !less(x, foo->v.arr+i)                         \
+			&& name##_mga_remove(&foo->v, i, 1)) {                \
+		foo->sorted--;                                                \
+		foo->idxok = false;                                           \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope void name##_set_index(name *foo, bool on)                               \
+{                                                                             \
+	if (foo && !(foo->indexed = on))                                      \
+		name##_freeindex_(foo);                                       \
+}                                                                             \
+									      \
+scope void name##_shrink_to_fit(name *foo)                                    \
+{                                                                             \
+	if (foo) {                                                            \
+		name##_freeindex_(foo);                                       \
+		name##_mga_shrink_to_fit(&foo->v);                            \
+	}                                                                     \
+}                                                                             \
+
+/* Expands function definitons for previously FLATMAP_DECL()'d name.
+ *
+ * Where "less" is as for FLATSET_DEF(), but compares name_keys;
+ * and the rest are as for MGA_DEF().
+ *
+ * Example : #define STRLESS(a, b) (strcmp(*(a), *(b)) < 0)
+ *           FLATMAP_DEF(static, symtab, STRLESS, realloc, free)
+ */
+#define FLATMAP_DEF(scope, name, less, reallocfn, freefn)                     \
+static inline bool name##_pairless_(const name##_pair *a,                     \
+		const name##_pair *b)                                         \
+{                                                                             \
+	return less(&a->key, &b->key);                                        \
+}                                                                             \
+FLATSET_DEF(scope, name, name##_pairless_, reallocfn, freefn)                 \
+									      \
+scope bool name##_put(name *foo, const name##_key *k, const name##_val *v)    \
+{                                                                             \
+	name##_pair p = {*k, *v};                                             \
+	return name##_insert(foo, &p);                                        \
+}                                                                             \
+									      \
+scope name##_val *name##_get(name *foo, const name##_key *k)                  \
+{                                                                             \
+	name##_pair p = {.key = *k}, *r = name##_find(foo, &p);               \
+	return r ? &r->val : NULL;                                            \
+}                                                                             \
+									      \
+scope bool name##_del(name *foo, const name##_key *k)                         \
+{                                                                             \
+	name##_pair p = {.key = *k};                                          \
+	return name##_remove(foo, &p);                                        \
+}                                                                             \
+
+#define FLATSET_IMPL(name, less, reallocfn, freefn, ...)                      \
+	FLATSET_DECL(FLAT_UNUSED static inline, name, __VA_ARGS__)            \
+	FLATSET_DEF(FLAT_UNUSED static inline, name, less, reallocfn, freefn)
+
+#define FLATMAP_IMPL(name, K, V, less, reallocfn, freefn)                     \
+	FLATMAP_DECL(FLAT_UNUSED static inline, name, K, V)                   \
+	FLATMAP_DEF(FLAT_UNUSED static inline, name, less, reallocfn, freefn)
+
+#endif
+#endif
@@ -2,30 +2,44 @@
 #include <stdbool.h> /* bool, true, false           */
 #include <string.h>  /* memcpy(), memmove()         */
 
-/* Edit the below to use a custom allocator */
+#include "../alloc/allocator.h" /* darc_allocator, darc_realloc(), darc_free() */
+#include "fpahdr.h" /* fpa_hdr */
+
+/* Edit the below to use a custom allocator,
+ * or define FPA_MMAPALLOC to map large arrays with mmap()/mremap().
+ */
+#ifdef FPA_MMAPALLOC
+#include "../alloc/mmapalloc.h"
+static void *(*const fpa_realloc)(void *, size_t) = mmapalloc_realloc;
+static void  (*const fpa_free)   (void *)         = mmapalloc_free;
+#else
 #include <stdlib.h>
 static void *(*const fpa_realloc)(void *, size_t) = realloc;
 static void  (*const fpa_free)   (void *)         = free;
+#endif
+
+/* Define FPA_STATS to count operations on all fpas, per thread */
+#ifdef FPA_STATS
+#include <stdio.h> /* FILE */
+#include "../stats/stats.h"
+static DARC_TLS darc_stats stats;
+#define stat(field, n) DARC_STAT_(stats, field, n)
+#define peak(sz) DARC_PEAK_(stats, sz)
+
+darc_stats fpa_stats(void) { return stats; }
+void fpa_stats_reset(void) { stats = (darc_stats){0}; }
+void fpa_stats_dump(FILE *f) { darc_stats_dump(f, "fpa", &stats); }
+#else
+#define stat(field, n) ((void)0)
+#define peak(sz) ((void)0)
+#endif
 
 #ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)-1)
 #endif
 
-/* Metadata header preceeding caller's array 
- * Aligned such that hdr * casts to any T * .
- */
-typedef struct hdr {
-	size_t len, cap, elsz;
-
-	#if __STDC_VERSION__ < 201112L
-	union {
-		long double f; long long i;
-		void *p; void (*fp)(void);
-	} _align[];
-	#else
-	max_align_t _align[];
-	#endif
-} hdr;
+/* Metadata header preceeding caller's array, see fpahdr.h */
+typedef fpa_hdr hdr;
 enum { HDRSZ = sizeof(hdr) };
 
 /* Returns maximum possible capacity for elements of given size */
@@ -54,30 +68,53 @@ void *fpa_cast(hdr *h, size_t elsz)
 		return NULL;
 }
 
-void *fpa_create(size_t n, size_t elsz)
+/* Reallocate or free a header and the array after it,
+ * given its current header h, with its allocator if it has one.
+ */
+static inline hdr *grow(hdr *p, const hdr *h, size_t newcap)
+{
+	size_t sz = newcap*h->elsz; /* h may be p, freed by realloc */
+	hdr *new = darc_realloc(h->alloc, fpa_realloc, p,
+			p ? HDRSZ + h->cap*h->elsz : 0, HDRSZ + sz);
+	if (new)
+		stat(reallocs, 1), peak(sz);
+	return new;
+}
+static inline void release(hdr *p)
+{
+	darc_free(p->alloc, fpa_free, p, HDRSZ + p->cap*p->elsz);
+}
+
+void *fpa_create_with(size_t n, size_t elsz, const darc_allocator *alloc)
 {
+	stat(create, 1);
 	if (elsz && n <= maxcap(elsz)) {
-		hdr *new = fpa_realloc(NULL, HDRSZ + n*elsz);
+		hdr h = {.len = 0, .cap = n, .elsz = elsz, .alloc = alloc};
+		hdr *new = grow(NULL, &h, n);
 		if (new) {
-			*new = (hdr) {.len = 0, .cap = n, .elsz = elsz};
+			*new = h;
 			return new+1; /* Return array region */
 		}
 	}
 	return NULL;
 }
 
+void *fpa_create(size_t n, size_t elsz) { return fpa_create_with(n, elsz, NULL); }
+
 /* Return pointer to metadata header given pointer to caller's array */
 static inline hdr *hdrp(hdr **fpa_ptr) { return (*fpa_ptr)-1; }
 
 void fpa_destroy(hdr **h)
 {
+	stat(destroy, 1);
 	if (h && *h)
-		fpa_free(hdrp(h)), *h = NULL;
+		release(hdrp(h)), *h = NULL;
 }
 
 bool fpa_reserve(hdr **foo, size_t n)
 {
 	register hdr h; /* header is saved to h, avoids repeated indirection */
+	stat(reserve, 1);
 
 	if ( foo && *foo && n <= maxcap((h = *hdrp(foo)).elsz) ) {
 		if (h.cap < n) {
@@ -85,7 +122,7 @@ bool fpa_reserve(hdr **foo, size_t n)
 			if (newcap < n || newcap > maxcap(h.elsz))
 				newcap = n;
 			
-			hdr *new = fpa_realloc(hdrp(foo), HDRSZ + newcap*h.elsz);
+			hdr *new = grow(hdrp(foo), hdrp(foo), newcap);
 			if(new) {
 				new->cap = newcap;
 				*foo = new+1; /* Update caller's data pointer */
@@ -104,6 +141,7 @@ bool fpa_insert(hdr **dst, size_t i, const void *restrict src, size_t n)
 	if (n == 0)
 		return true;
 
+	stat(insert, 1);
 	register hdr h;
 	if (dst && *dst && maxcap((h = *hdrp(dst)).elsz) - n >= h.len
 			&& i <= h.len && fpa_reserve(dst, h.len+n)) {
@@ -112,9 +150,10 @@ bool fpa_insert(hdr **dst, size_t i, const void *restrict src, size_t n)
 
 		/* move elements at i to i+n to preserve them */
 		memmove(at_i + n*h.elsz, at_i, (h.len-i)*h.elsz);
+		stat(moved, (h.len-i)*h.elsz);
 		/* if src == NULL, caller will emplace, don't copy */
 		if (src)
-			memcpy(at_i, src, n*h.elsz);
+			memcpy(at_i, src, n*h.elsz), stat(copied, n*h.elsz);
 
 		hdrp(dst)->len = h.len+n;
 		return true;
@@ -122,11 +161,61 @@ bool fpa_insert(hdr **dst, size_t i, const void *restrict src, size_t n)
 		return false;
 }
 
+/* Mirrors fpa_ins in fpa.h */
+typedef struct fpa_ins {
+	size_t i;
+	const void *src;
+	size_t n;
+} fpa_ins;
+
+bool fpa_insert_many(hdr **dst, const fpa_ins *ins, size_t k)
+{
+	register hdr h;
+	register size_t total = 0;
+	stat(insert_many, 1);
+	if (!dst || !*dst || (k && !ins))
+		return false;
+
+	h = *hdrp(dst);
+	for (size_t g = 0; g < k; g++)
+		if (ins[g].i > h.len || (g && ins[g].i < ins[g-1].i)
+				|| maxcap(h.elsz)-h.len-total < ins[g].n)
+			return false;
+		else
+			total += ins[g].n;
+
+	if (total && fpa_reserve(dst, h.len+total)) {
+		byte *arr = (byte *)(*dst);
+		register size_t end = h.len;
+
+		hdrp(dst)->len = h.len+total;
+		/* Back to front, move elements at [i, end) to their final
+		 * place, total ahead, then fill the group in before them.
+		 */
+		for (size_t g = k; g--; end = ins[g].i) {
+			byte *at_i = arr + ins[g].i*h.elsz;
+
+			memmove(at_i + total*h.elsz, at_i,
+					(end-ins[g].i)*h.elsz);
+			stat(moved, (end-ins[g].i)*h.elsz);
+			total -= ins[g].n;
+			/* if src == NULL, caller will emplace, don't copy */
+			if (ins[g].src)
+				memcpy(at_i + total*h.elsz, ins[g].src,
+						ins[g].n*h.elsz),
+				stat(copied, ins[g].n*h.elsz);
+		}
+		return true;
+	} else
+		return !total;
+}
+
 bool fpa_selfinsert(hdr **foo, size_t idst, size_t isrc, size_t n)
 {
 	if (n == 0)
 		return true;
 
+	stat(selfinsert, 1);
 	register hdr h;
 	if (foo && *foo && maxcap((h = *hdrp(foo)).elsz) - n >= h.len
 			&& idst <= h.len && isrc < h.len && fpa_reserve(foo, h.len+n)) {
@@ -140,6 +229,7 @@ bool fpa_selfinsert(hdr **foo, size_t idst, size_t isrc, size_t n)
 		 */
 		memmove(at_idst, at_isrc + (idst < isrc) * n*h.elsz,
 				n*h.elsz * (idst != isrc));
+		stat(moved, (h.len-idst)*h.elsz + n*h.elsz * (idst != isrc));
 
 		hdrp(foo)->len = h.len+n;
 		return true;
@@ -153,11 +243,13 @@ bool fpa_selfinsert(hdr **foo, size_t idst, size_t isrc, size_t n)
 bool fpa_remove(hdr *dst, size_t i, size_t n)
 {
 	register hdr h;
+	stat(remove, 1);
 	if (dst && maxcap((h = dst[-1]).elsz) - i >= n && i+n <= h.len) {
 		
 		byte *at_i = (byte *)dst + i*h.elsz;
 		/* Shift elements at index > i one step back */
 		memmove(at_i, at_i + n*h.elsz, (h.len-i-n)*h.elsz);
+		stat(moved, (h.len-i-n)*h.elsz);
 
 		dst[-1].len = h.len-n;
 		return true;
@@ -165,12 +257,72 @@ bool fpa_remove(hdr *dst, size_t i, size_t n)
 		return false;
 }
 
+size_t fpa_remove_if(hdr *foo, bool (*pred)(const void *, void *), void *ctx)
+{
+	stat(remove_if, 1);
+	if (!foo)
+		return 0;
+
+	register hdr h = foo[-1];
+	byte *arr = (byte *)foo;
+	register size_t r = 0, w;
+
+	/* Elements before the first removed one stay put */
+	while (r < h.len && !pred(arr + r*h.elsz, ctx))
+		r++;
+	for (w = r; r < h.len; ) {
+		while (r < h.len && pred(arr + r*h.elsz, ctx))
+			r++;
+		register size_t run = r;
+		while (r < h.len && !pred(arr + r*h.elsz, ctx))
+			r++;
+		/* Move the kept run straight to its final place */
+		memmove(arr + w*h.elsz, arr + run*h.elsz, (r-run)*h.elsz);
+		stat(moved, (r-run)*h.elsz);
+		w += r-run;
+	}
+	foo[-1].len = w;
+	return h.len-w;
+}
+
+/* Mirrors fpa_range in fpa.h */
+typedef struct fpa_range {
+	size_t i, n;
+} fpa_range;
+
+bool fpa_remove_many(hdr *dst, const fpa_range *r, size_t k)
+{
+	stat(remove_many, 1);
+	if (!dst || (k && !r))
+		return false;
+
+	register hdr h = dst[-1];
+	for (size_t g = 0; g < k; g++)
+		if (maxcap(h.elsz)-r[g].i < r[g].n || r[g].i+r[g].n > h.len
+			|| (g && r[g].i < r[g-1].i+r[g-1].n))
+			return false;
+
+	byte *arr = (byte *)dst;
+	register size_t w = k? r[0].i : h.len;
+	for (size_t g = 0; g < k; g++) {
+		/* Shift elements between this range and the next back */
+		register size_t from = r[g].i+r[g].n;
+		register size_t to = g+1 < k ? r[g+1].i : h.len;
+		memmove(arr + w*h.elsz, arr + from*h.elsz, (to-from)*h.elsz);
+		stat(moved, (to-from)*h.elsz);
+		w += to-from;
+	}
+	dst[-1].len = w;
+	return true;
+}
+
 void fpa_shrink_to_fit(hdr **foo)
 {
 	register hdr h;
+	stat(shrink_to_fit, 1);
 	/* Avoid realloc() call if not needed */
 	if (foo && *foo && (h = *hdrp(foo)).cap > h.len) {
-		struct hdr *new = fpa_realloc(hdrp(foo), HDRSZ + h.len*h.elsz);
+		hdr *new = grow(hdrp(foo), hdrp(foo), h.len);
 		if (new)
 			new->cap = h.len, *foo = new+1;
 	}
@@ -1,6 +1,11 @@
+#ifndef FPA_H
+#define FPA_H
+
 #include <stdbool.h> /* bool              */
 #include <stddef.h>  /* size_t, ptrdiff_t */
 
+#include "../alloc/allocator.h" /* darc_allocator */
+
 /* fpa methods interact with an fpa object in one of three ways :
  * 1. fpa
  *    This is a pointer to the array data's 0th element.
@@ -48,6 +53,11 @@ fpa fpa_cast(fpa, size_t elsz);
  */
 fpa fpa_create(size_t n, size_t elsz);
 
+/* Like fpa_create(), but allocating with alloc,
+ * which must outlive the fpa.
+ */
+fpa fpa_create_with(size_t n, size_t elsz, const darc_allocator *alloc);
+
 /* free()'s internal allocations & NULLs fpa. */
 void fpa_destroy(fpa_ptr);
 
@@ -65,6 +75,22 @@ bool fpa_reserve(fpa_ptr, size_t n);
  */
 bool fpa_insert(fpa_ptr, size_t i, const void *restrict src, size_t n);
 
+/* Describes n elements from src to insert before index i */
+typedef struct fpa_ins {
+	size_t i;
+	const void *src;
+	size_t n;
+} fpa_ins;
+
+/* Inserts k groups of elements, each as if by fpa_insert(),
+ * where .i indexes the fpa as it was before the call.
+ * Groups must be sorted by .i; groups with equal .i are inserted in order.
+ * Reserves at most once and moves each element at most once.
+ *
+ * Returns true if successful, else false.
+ */
+bool fpa_insert_many(fpa_ptr, const fpa_ins *ins, size_t k);
+
 /* Inserts n elements from index isrc at index idst.
  * Returns true on success and false on failure.
  */
@@ -75,7 +101,40 @@ bool fpa_selfinsert(fpa_ptr, size_t idst, size_t isrc, size_t n);
  */
 bool fpa_remove(fpa, size_t i, size_t n);
 
+/* Removes elements for which pred(element, ctx) is true,
+ * in a single pass that keeps the order of the rest.
+ * Returns how many were removed.
+ */
+size_t fpa_remove_if(fpa, bool (*pred)(const void *el, void *ctx), void *ctx);
+
+/* Describes n elements from index i onwards */
+typedef struct fpa_range {
+	size_t i, n;
+} fpa_range;
+
+/* Removes k ranges of elements in a single pass,
+ * where .i indexes the fpa as it was before the call.
+ * Ranges must be sorted by .i and not overlap.
+ *
+ * Returns true on success and false on failure (out-of-bounds, unsorted).
+ */
+bool fpa_remove_many(fpa, const fpa_range *r, size_t k);
+
 /* Dynamic arrays overallocate for efficiency,
  * Reallocs fpa to eliminate redundant space, if any.
  */
 void fpa_shrink_to_fit(fpa_ptr);
+
+/* Compile fpa.c with FPA_STATS to count this thread's operations on fpas,
+ * see stats/stats.h.
+ */
+#ifdef FPA_STATS
+#include <stdio.h> /* FILE */
+#include "../stats/stats.h"
+
+darc_stats fpa_stats(void);
+void fpa_stats_reset(void);
+void fpa_stats_dump(FILE *);
+#endif
+
+#endif
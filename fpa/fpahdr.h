@@ -0,0 +1,26 @@
+#ifndef FPAHDR_H
+#define FPAHDR_H
+
+#include <stddef.h> /* size_t, max_align_t */
+
+#include "../alloc/allocator.h" /* darc_allocator */
+
+/* Metadata header preceeding an fpa's array,
+ * shared by fpa.c and the typed bindings of tbfpa.h.
+ * Aligned such that fpa_hdr * casts to any T * .
+ */
+typedef struct fpa_hdr {
+	size_t len, cap, elsz;
+	const darc_allocator *alloc; /* NULL for fpa.c's realloc/free */
+
+	#if __STDC_VERSION__ < 201112L
+	union {
+		long double f; long long i;
+		void *p; void (*fp)(void);
+	} _align[];
+	#else
+	max_align_t _align[];
+	#endif
+} fpa_hdr;
+
+#endif
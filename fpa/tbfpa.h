@@ -0,0 +1,182 @@
+#ifndef TBFPA_H
+#define TBFPA_H
+
+#include <string.h> /* memcpy(), memmove() */
+
+#include "fpa.h"
+#include "fpahdr.h" /* fpa_hdr */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define TBFPA_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define TBFPA_UNUSED __attribute__((unused))
+#else
+	#define TBFPA_UNUSED
+#endif
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+/* With FPA_STATS defined, as fpa.c must be compiled with too, the inlined
+ * functions call fpa's instead, so that its counters include them.
+ */
+#ifdef FPA_STATS
+#define TBFPA_INLINE_ false
+#else
+#define TBFPA_INLINE_ true
+#endif
+
+/* Alias `name` with a pointer to eltype `...` and generate typed bindings
+ * to fpa, like stb_ds's arrput()/arrlen().
+ *
+ * Unlike fpa's, these know the element size at compile time and read the
+ * header once, directly : name_len(), name_cap(), name_push(), name_pop(),
+ * name_reserve() when there's room, name_insert() and name_remove() are
+ * inlined whole, and call fpa only to grow, unless FPA_STATS is defined.
+ * The rest forward to fpa, and all of them work on the same arrays as fpa's
+ * functions, whose elsz must be sizeof(name_eltype).
+ */
+#define TBFPA_GEN(name, ...)                                                 \
+typedef __VA_ARGS__ name##_eltype;                                           \
+typedef name##_eltype *name;                                                 \
+typedef fpa_ins name##_ins;                                                  \
+typedef fpa_range name##_range;                                              \
+									     \
+TBFPA_UNUSED static const size_t name##_maxcap =                             \
+	(SIZE_MAX-sizeof(fpa_hdr))/sizeof(name##_eltype);                    \
+									     \
+TBFPA_UNUSED static inline fpa_hdr *name##_hdr_(const name##_eltype *foo)    \
+{                                                                            \
+	return (fpa_hdr *)foo - 1; /* Const cast */                          \
+}                                                                            \
+TBFPA_UNUSED static inline size_t name##_len(const name##_eltype *foo)       \
+{                                                                            \
+	return foo? name##_hdr_(foo)->len : 0;                               \
+}                                                                            \
+TBFPA_UNUSED static inline size_t name##_cap(const name##_eltype *foo)       \
+{                                                                            \
+	return foo? name##_hdr_(foo)->cap : 0;                               \
+}                                                                            \
+									     \
+TBFPA_UNUSED static inline name name##_create(size_t n)                      \
+{                                                                            \
+	return fpa_create(n, sizeof(name##_eltype));                         \
+}                                                                            \
+TBFPA_UNUSED static inline name name##_create_with(size_t n,                 \
+		const darc_allocator *alloc)                                 \
+{                                                                            \
+	return fpa_create_with(n, sizeof(name##_eltype), alloc);             \
+}                                                                            \
+TBFPA_UNUSED static inline void name##_destroy(name *foo)                    \
+{                                                                            \
+	fpa_destroy(foo);                                                    \
+}                                                                            \
+TBFPA_UNUSED static inline bool name##_reserve(name *foo, size_t n)          \
+{                                                                            \
+	if (TBFPA_INLINE_ && foo && *foo && name##_hdr_(*foo)->cap >= n)     \
+		return true;                                                 \
+	else                                                                 \
+		return fpa_reserve(foo, n);                                  \
+}                                                                            \
+									     \
+/* Appends x, returns false if it can't grow */                              \
+TBFPA_UNUSED static inline bool name##_push(name *foo, name##_eltype x)      \
+{                                                                            \
+	if (!foo || !*foo)                                                   \
+		return false;                                                \
+									     \
+	register fpa_hdr *h = name##_hdr_(*foo);                             \
+	if (TBFPA_INLINE_ && h->len < h->cap) {                              \
+		(*foo)[h->len++] = x;                                        \
+		return true;                                                 \
+	} else                                                               \
+		return fpa_insert(foo, h->len, &x, 1);                       \
+}                                                                            \
+/* Removes and returns the last element, UB if there's none */               \
+TBFPA_UNUSED static inline name##_eltype name##_pop(name foo)                \
+{                                                                            \
+	register size_t len = name##_hdr_(foo)->len;                         \
+	name##_eltype x = foo[len-1];                                        \
+									     \
+	if (TBFPA_INLINE_)                                                   \
+		name##_hdr_(foo)->len = len-1;                               \
+	else                                                                 \
+		fpa_remove(foo, len-1, 1);                                   \
+	return x;                                                            \
+}                                                                            \
+									     \
+TBFPA_UNUSED static inline bool name##_insert(                               \
+	name *dst, size_t i, const name##_eltype *restrict src, size_t n     \
+)                                                                            \
+{                                                                            \
+	enum { elsz = sizeof(name##_eltype) };                               \
+									     \
+	if (!TBFPA_INLINE_)                                                  \
+		return fpa_insert(dst, i, src, n);                           \
+	else if (n == 0)                                                     \
+		return true;                                                 \
+									     \
+	register size_t len;                                                 \
+	if (dst && *dst && name##_maxcap-n >= (len = name##_hdr_(*dst)->len) \
+			&& i <= len && name##_reserve(dst, len+n)) {         \
+									     \
+		register name##_eltype *arr = *dst;                          \
+		/* move elements at i to i+n to preserve them */             \
+		memmove(arr+i+n, arr+i, (len-i)*elsz);                       \
+		/* if src == NULL, caller will emplace, don't copy */        \
+		if (src)                                                     \
+			memcpy(arr+i, src, n*elsz);                          \
+									     \
+		name##_hdr_(arr)->len = len+n;                               \
+		return true;                                                 \
+	} else                                                               \
+		return false;                                                \
+}                                                                            \
+TBFPA_UNUSED static inline bool name##_insert_many(                          \
+	name *dst, const name##_ins *ins, size_t k                           \
+)                                                                            \
+{                                                                            \
+	return fpa_insert_many(dst, ins, k);                                 \
+}                                                                            \
+TBFPA_UNUSED static inline bool name##_selfinsert(                           \
+	name *foo, size_t idst, size_t isrc, size_t n                        \
+)                                                                            \
+{                                                                            \
+	return fpa_selfinsert(foo, idst, isrc, n);                           \
+}                                                                            \
+TBFPA_UNUSED static inline bool name##_remove(name foo, size_t i, size_t n)  \
+{                                                                            \
+	enum { elsz = sizeof(name##_eltype) };                               \
+									     \
+	register fpa_hdr *h;                                                 \
+	if (!TBFPA_INLINE_)                                                  \
+		return fpa_remove(foo, i, n);                                \
+	else if (foo && name##_maxcap-i >= n                                 \
+			&& i+n <= (h = name##_hdr_(foo))->len) {             \
+		/* Shift elements at index > i one step back */              \
+		memmove(foo+i, foo+i+n, (h->len-i-n)*elsz);                  \
+		h->len -= n;                                                 \
+		return true;                                                 \
+	} else                                                               \
+		return false;                                                \
+}                                                                            \
+TBFPA_UNUSED static inline size_t name##_remove_if(                          \
+	name foo, bool (*pred)(const void *, void *), void *ctx              \
+)                                                                            \
+{                                                                            \
+	return fpa_remove_if(foo, pred, ctx);                                \
+}                                                                            \
+TBFPA_UNUSED static inline bool name##_remove_many(                          \
+	name foo, const name##_range *r, size_t k                            \
+)                                                                            \
+{                                                                            \
+	return fpa_remove_many(foo, r, k);                                   \
+}                                                                            \
+TBFPA_UNUSED static inline void name##_shrink_to_fit(name *foo)              \
+{                                                                            \
+	fpa_shrink_to_fit(foo);                                              \
+}
+
+#endif
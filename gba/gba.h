@@ -0,0 +1,278 @@
+#ifndef GBA_H
+#define GBA_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+
+#include "../alloc/allocator.h" /* darc_allocator */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define GBA_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define GBA_UNUSED __attribute__((unused))
+#else
+	#define GBA_UNUSED
+#endif
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+/* Declares a gap buffer instantiation with given name,
+ * scope and "..." element type.
+ *
+ * A gap buffer keeps its unused capacity as a "gap" at some position
+ * inside arr, instead of at the end. Elements [0, gap) are at arr[0, gap)
+ * and elements [gap, len) are at the end of arr, after cap-len free slots.
+ * Inserting or removing at the gap costs nothing but copying the inserted
+ * elements, and moving the gap costs the distance it moves; so clustered
+ * edits around a moving cursor are cheap, unlike in mga.
+ *
+ * Where,
+ * - "scope" is empty or a valid prefix for a function declaration,
+ *   like static, inline, etc.
+ * - "name" is a valid identifier.
+ * - "..." is a type name such that a suffixed "*" creates
+ *   a pointer to that type.
+ *
+ * Example : GBA_DECL(, text, char)
+ * Declares text for chars with functions in the global scope.
+ *
+ * An instance whose alloc is not NULL allocates with *alloc instead
+ * of the functions given to GBA_DEF(), and *alloc must outlive it.
+ *
+ * - Member types :
+ *   - name_eltype, the type of the elements (aka value_type).
+ * - Member constants :
+ *   - name_maxcap, the maxmimum number of elements.
+ *   - name_realloc, name_free; aliases of reallocfn(),freefn().
+ *
+ * - Member functions :
+ *   - name_create()
+ *   - name_create_with(), which also sets the allocator alloc.
+ *   - name_destroy()
+ *   - name_reserve()
+ *   - name_insert()
+ *   - name_selfinsert()
+ *   - name_remove()
+ *   - name_shrink_to_fit()
+ *   - name_movegap(), moves the gap to given index.
+ *   - name_at(), returns pointer to element at given index.
+ *   - name_view(), moves the gap to the end and returns arr,
+ *     a contiguous array of len elements, as in mga.
+ */
+#define GBA_DECL(scope, name, ...)                                            \
+typedef __VA_ARGS__ name##_eltype;                                            \
+typedef struct name {                                                         \
+	size_t len, cap, gap; name##_eltype *arr;                             \
+	const darc_allocator *alloc;                                          \
+} name;                                                                       \
+									      \
+GBA_UNUSED static const size_t name##_maxcap =                                \
+	SIZE_MAX/sizeof(name##_eltype);                                       \
+									      \
+scope name name##_create(size_t);                                             \
+scope name name##_create_with(size_t, const darc_allocator *alloc);           \
+scope void name##_destroy(name *);                                            \
+scope bool name##_reserve(name *, size_t);                                    \
+scope bool name##_insert(name *, size_t i, const name##_eltype *restrict src, \
+								   size_t n); \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
+scope bool name##_remove(name *, size_t i, size_t n);                         \
+scope void name##_shrink_to_fit(name *);                                      \
+scope bool name##_movegap(name *, size_t i);                                  \
+scope name##_eltype *name##_at(const name *, size_t i);                       \
+scope name##_eltype *name##_view(name *);                                     \
+
+/* Define GBA_NOIMPL to strip implementation code */
+#ifndef GBA_NOIMPL
+
+#include <string.h>  /* memcpy(), memmove() */
+
+/* Expands function definitons for previously GBA_DECL()'d name
+ *
+ * Where "reallocfn", "freefn" are as specified for MGA_DEF().
+ */
+#define GBA_DEF(scope, name, reallocfn, freefn)                               \
+static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
+static void (*const name##_free)(void *) = freefn;                            \
+									      \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	name res = {.alloc = alloc};                                          \
+	if (n && n <= name##_maxcap && (res.arr = darc_realloc(               \
+			alloc, name##_realloc, NULL, 0, n*elsz)) )            \
+		res.cap = n;                                                  \
+	return res;                                                           \
+}                                                                             \
+									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_with(n, NULL);                                   \
+}                                                                             \
+									      \
+/* Keeps the allocator, so foo may be reused. */                              \
+scope void name##_destroy(name *foo)                                          \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo)                                                              \
+		darc_free(foo->alloc, name##_free, foo->arr, foo->cap*elsz),  \
+		*foo = (name){.alloc = foo->alloc};                           \
+}                                                                             \
+									      \
+scope bool name##_reserve(name *foo, size_t n)                                \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo && n <= name##_maxcap) {                                      \
+		register name m = *foo;                                       \
+									      \
+		if (m.cap < n) {                                              \
+			size_t newcap = m.cap+m.cap/2; /* Try growing 1.5x */ \
+			/* Or grow to n elements if its bigger or overflow */ \
+			if (newcap < n || newcap > name##_maxcap)             \
+				newcap = n;                                   \
+									      \
+			name##_eltype *p = darc_realloc(m.alloc,              \
+				name##_realloc, m.arr, m.cap*elsz,            \
+				newcap*elsz);                                 \
+			if (!p)                                               \
+				return false;                                 \
+									      \
+			/* Widen the gap by moving elements after it */       \
+			memmove(p + m.gap + newcap-m.len,                     \
+				p + m.gap + m.cap-m.len, (m.len-m.gap)*elsz); \
+			foo->arr = p, foo->cap = newcap;                      \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_movegap(name *foo, size_t i)                                \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	register name m;                                                      \
+	if (foo && i <= (m = *foo).len) {                                     \
+		register size_t gaplen = m.cap-m.len;                         \
+									      \
+		/* Move elements between i and the gap across the gap */      \
+		if (i < m.gap)                                                \
+			memmove(m.arr+i+gaplen, m.arr+i, (m.gap-i)*elsz);     \
+		else if (i > m.gap)                                           \
+			memmove(m.arr+m.gap, m.arr+m.gap+gaplen,              \
+					(i-m.gap)*elsz);                      \
+		foo->gap = i;                                                 \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope name##_eltype *name##_at(const name *foo, size_t i)                     \
+{                                                                             \
+	if (foo && i < foo->len)                                              \
+		return foo->arr + i + (i >= foo->gap)*(foo->cap-foo->len);    \
+	else                                                                  \
+		return NULL;                                                  \
+}                                                                             \
+									      \
+scope name##_eltype *name##_view(name *foo)                                   \
+{                                                                             \
+	return foo && name##_movegap(foo, foo->len) ? foo->arr : NULL;        \
+}                                                                             \
+									      \
+/* If src is NULL, elements [i, i+n) are left for caller to emplace
+ * at arr[i, i+n), which is contiguous as the gap starts at i+n after.
+ */                                                                           \
+scope bool name##_insert(name *dst, size_t i,                                 \
+		const name##_eltype *restrict src, size_t n)                  \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-n >= (len = dst->len) && i <= len            \
+			&& name##_reserve(dst, len+n)) {                      \
+		name##_movegap(dst, i);                                       \
+									      \
+		/* if src is NULL, caller will emplace, don't copy */         \
+		if (src)                                                      \
+			memcpy(dst->arr+i, src, n*elsz);                      \
+									      \
+		dst->gap = i+n, dst->len = len+n;                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* Elements [isrc, isrc+n) must exist. */                                     \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (foo && name##_maxcap-n >= (len = foo->len) && idst <= len         \
+		&& isrc < len && n <= len-isrc                                \
+		&& name##_reserve(foo, len+n) && name##_movegap(foo, idst)) { \
+		register name##_eltype *arr = foo->arr;                       \
+		register size_t gaplen = foo->cap-len;                        \
+									      \
+		/* Source may straddle the gap, now at idst.
+		 * Neither part overlaps the gap, which holds at least n.
+		 */                                                           \
+		register size_t pre = isrc < idst ? idst-isrc : 0;            \
+		if (pre > n)                                                  \
+			pre = n;                                              \
+		memcpy(arr+idst, arr+isrc, pre*elsz);                         \
+		memcpy(arr+idst+pre, arr+isrc+pre+gaplen, (n-pre)*elsz);      \
+									      \
+		foo->gap = idst+n, foo->len = len+n;                          \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_remove(name *dst, size_t i, size_t n)                       \
+{                                                                             \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-i >= n && i+n <= (len = dst->len)            \
+			&& name##_movegap(dst, i)) {                          \
+		/* Elements after the gap start n later, widening it */       \
+		dst->len = len-n;                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope void name##_shrink_to_fit(name *foo)                                    \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	/* Avoid reallocation if not needed, or to 0 bytes, which may free */ \
+	if (foo && !foo->len)                                                 \
+		name##_destroy(foo);                                          \
+	else if (foo && foo->cap > foo->len                                   \
+			&& name##_movegap(foo, foo->len)) {                   \
+		void *p = darc_realloc(foo->alloc, name##_realloc,            \
+				foo->arr, foo->cap*elsz, foo->len*elsz);      \
+		if (p)                                                        \
+			foo->arr = p, foo->cap = foo->len;                    \
+	}                                                                     \
+}                                                                             \
+
+#define GBA_IMPL(name, reallocfn, freefn, ...)                                \
+	GBA_DECL(GBA_UNUSED static inline, name, __VA_ARGS__)                 \
+	GBA_DEF(GBA_UNUSED static inline, name, reallocfn, freefn)
+
+#endif
+#endif
@@ -4,6 +4,8 @@
 #include <stdbool.h> /* bool, true, false */
 #include <stddef.h>  /* size_t            */
 
+#include "../alloc/allocator.h" /* darc_allocator */
+
 /* Silence unnecessary compiler warnings when static funcs/vars unused. */
 #if __STDC_VERSION__ >= 202311L
 	#define MGA_UNUSED [[maybe_unused]]
@@ -15,6 +17,20 @@
 
 #ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)-1)
+#endif
+
+/* Define MGA_STATS to count operations per instantiation and thread,
+ * see stats/stats.h. Otherwise, counting compiles to nothing.
+ */
+#ifdef MGA_STATS
+#include <stdio.h> /* FILE */
+#include "../stats/stats.h"
+#define MGA_STATS_DECL_(scope, name)                                          \
+scope darc_stats name##_stats(void);                                          \
+scope void name##_stats_reset(void);                                          \
+scope void name##_stats_dump(FILE *);
+#else
+#define MGA_STATS_DECL_(scope, name)
 #endif                                                                             
  
 /* Declares an instantiation with given name, alloction functions,
@@ -35,68 +51,174 @@
  * Declares ivec for ints with functions in the global scope
  * using stdlib realloc/free for allocation/deallocation.
  *
+ * An instance whose alloc is not NULL allocates with *alloc instead,
+ * which must outlive the instance.
+ *
  * - Member types :
  *   - name_eltype, the type of the elements (aka value_type).
+ *   - name_ins, describing n elements from src to insert before arr[i].
+ *   - name_range, describing n elements from arr[i] onwards.
  * - Member constants : 
  *   - name_maxcap, the maxmimum number of elements.
  *   - name_realloc, name_free; aliases of reallocfn(),freefn().
  *
  * - Member functions :
  *   - name_create()
+ *   - name_create_with(), which also sets the allocator alloc.
  *   - name_destroy()
  *   - name_reserve()
  *   - name_insert()
+ *   - name_insert_many()
  *   - name_selfinsert()
  *   - name_remove()
+ *   - name_remove_if()
+ *   - name_remove_many()
  *   - name_shrink_to_fit()
  */
 #define MGA_DECL(scope, name, ...)                         \
 typedef __VA_ARGS__ name##_eltype;                                            \
-typedef struct name { size_t len, cap; name##_eltype *arr; } name;            \
+typedef struct name {                                                         \
+	size_t len, cap; name##_eltype *arr;                                  \
+	const darc_allocator *alloc;                                          \
+} name;                                                                       \
+typedef struct name##_ins {                                                   \
+	size_t i; const name##_eltype *src; size_t n;                         \
+} name##_ins;                                                                 \
+typedef struct name##_range { size_t i, n; } name##_range;                    \
 									      \
 MGA_UNUSED static const size_t name##_maxcap =                                \
 	SIZE_MAX/sizeof(name##_eltype);                                       \
 									      \
 scope name name##_create(size_t);                                             \
+scope name name##_create_with(size_t, const darc_allocator *alloc);           \
 scope void name##_destroy(name *);                                            \
 scope bool name##_reserve(name *, size_t);                                    \
 scope bool name##_insert(name *, size_t i, const name##_eltype *restrict src, \
 								   size_t n); \
+scope bool name##_insert_many(name *, const name##_ins *ins, size_t k);       \
 scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
 scope bool name##_remove(name *, size_t i, size_t n);		              \
+scope size_t name##_remove_if(name *,                                         \
+		bool (*pred)(const name##_eltype *, void *ctx), void *ctx);   \
+scope bool name##_remove_many(name *, const name##_range *r, size_t k);       \
 scope void name##_shrink_to_fit(name *);                                      \
+MGA_STATS_DECL_(scope, name)                                                  \
 
 /* Define MGA_NOIMPL to strip implementation code */
 #ifndef MGA_NOIMPL
 
 #include <string.h>  /* memcpy(), memmove() */
 
+/* Define MGA_PMOVE to shift very large arrays with several threads */
+#ifdef MGA_PMOVE
+#include "../pmove/pmove.h"
+#define MGA_MOVE_ pmove
+#else
+#define MGA_MOVE_ memmove
+#endif
+
+#ifdef MGA_STATS
+#define MGA_STATS_DEF_(scope, name)                                           \
+static DARC_TLS darc_stats name##_stats_;                                     \
+scope darc_stats name##_stats(void) { return name##_stats_; }                 \
+scope void name##_stats_reset(void) { name##_stats_ = (darc_stats){0}; }      \
+scope void name##_stats_dump(FILE *f)                                         \
+{                                                                             \
+	darc_stats_dump(f, #name, &name##_stats_);                            \
+}
+#define MGA_STAT_(name, field, n) DARC_STAT_(name##_stats_, field, n)
+#define MGA_PEAK_(name, sz) DARC_PEAK_(name##_stats_, sz)
+#else
+#define MGA_STATS_DEF_(scope, name)
+#define MGA_STAT_(name, field, n) ((void)0)
+#define MGA_PEAK_(name, sz) ((void)0)
+#endif
+
+/* Body of a function with params "name *foo" and "void *ctx", that removes
+ * elements for which pred(const name_eltype *, ctx) is true, keeping the
+ * order of the rest, and returns how many it removed.
+ *
+ * Kept runs are moved once, each straight to its final place,
+ * and pred sees every element before anything is moved over it.
+ */
+#define MGA_REMOVE_IF_BODY_(name, pred)                                       \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	MGA_STAT_(name, remove_if, 1);                                        \
+	if (!foo)                                                             \
+		return 0;                                                     \
+									      \
+	register name m = *foo;                                               \
+	register size_t r = 0, w;                                             \
+									      \
+	/* Elements before the first removed one stay put */                  \
+	while (r < m.len && !pred(m.arr+r, ctx))                              \
+		r++;                                                          \
+	for (w = r; r < m.len; ) {                                            \
+		while (r < m.len && pred(m.arr+r, ctx))                       \
+			r++;                                                  \
+		register size_t run = r;                                      \
+		while (r < m.len && !pred(m.arr+r, ctx))                      \
+			r++;                                                  \
+		MGA_MOVE_(m.arr+w, m.arr+run, (r-run)*elsz);                  \
+		MGA_STAT_(name, moved, (r-run)*elsz);                         \
+		w += r-run;                                                   \
+	}                                                                     \
+	foo->len = w;                                                         \
+	return m.len-w;                                                       \
+
+/* Defines "scope size_t fn(name *foo, void *ctx)" for previously MGA_DECL()'d
+ * name, which does the same as name_remove_if(foo, pred, ctx).
+ *
+ * Where "pred" is a function or function-like macro, that is called
+ * directly and so can be inlined, unlike the pointer name_remove_if() takes.
+ */
+#define MGA_REMOVE_IF_DEF(scope, fn, name, pred)                              \
+scope size_t fn(name *foo, void *ctx)                                         \
+{                                                                             \
+	MGA_REMOVE_IF_BODY_(name, pred)                                       \
+}                                                                             \
+
 /* Expands function definitons for previously MGA_DECL()'d name */
 #define MGA_DEF(scope, name, reallocfn, freefn)                               \
 static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
 static void (*const name##_free)(void *) = freefn;                            \
+MGA_STATS_DEF_(scope, name)                                                   \
 									      \
-scope name name##_create(size_t n)                                            \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
 {                                                                             \
 	enum { elsz = sizeof(name##_eltype) };                                \
 									      \
-	name res = {0};                                                       \
-	if (n && n <= name##_maxcap                                           \
-			&& (res.arr = name##_realloc(NULL, n*elsz)) )         \
-		res.cap = n;                                                  \
+	name res = {.alloc = alloc};                                          \
+	MGA_STAT_(name, create, 1);                                           \
+	if (n && n <= name##_maxcap && (res.arr = darc_realloc(               \
+			alloc, name##_realloc, NULL, 0, n*elsz)) )            \
+		res.cap = n, MGA_STAT_(name, reallocs, 1),                    \
+			MGA_PEAK_(name, n*elsz);                              \
 	return res;                                                           \
 }                                                                             \
 									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_with(n, NULL);                                   \
+}                                                                             \
+									      \
+/* Keeps the allocator, so foo may be reused. */                              \
 scope void name##_destroy(name *foo)                                          \
 {                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	MGA_STAT_(name, destroy, 1);                                          \
 	if (foo)                                                              \
-		name##_free(foo->arr), *foo = (name){0};                      \
+		darc_free(foo->alloc, name##_free, foo->arr, foo->cap*elsz),  \
+		*foo = (name){.alloc = foo->alloc};                           \
 }                                                                             \
 									      \
 scope bool name##_reserve(name *foo, size_t n)                                \
 {                                                                             \
 	enum { elsz = sizeof(name##_eltype) };                                \
 									      \
+	MGA_STAT_(name, reserve, 1);                                          \
 	if (foo && n <= name##_maxcap) {                                      \
 		register size_t cap = foo->cap;                               \
 									      \
@@ -106,9 +228,12 @@ scope bool name##_reserve(name *foo, size_t n)                                \
 			if (newcap < n || newcap > name##_maxcap)             \
 				newcap = n;                                   \
 									      \
-			void *p = name##_realloc(foo->arr, newcap*elsz);      \
+			void *p = darc_realloc(foo->alloc, name##_realloc,    \
+					foo->arr, cap*elsz, newcap*elsz);     \
 			if (p)                                                \
-				foo->arr = p, foo->cap = newcap;              \
+				foo->arr = p, foo->cap = newcap,              \
+				MGA_STAT_(name, reallocs, 1),                 \
+				MGA_PEAK_(name, newcap*elsz);                 \
 			else                                                  \
 				return false;                                 \
 		}                                                             \
@@ -125,17 +250,20 @@ scope bool name##_insert(name *dst, size_t i,                                 \
 	if (!n)                                                               \
 		return true;                                                  \
 									      \
+	MGA_STAT_(name, insert, 1);                                           \
 	register size_t len;                                                  \
 	if (dst && name##_maxcap-n >= (len = dst->len) && i <= len            \
 			&& name##_reserve(dst, len+n)) {                      \
 		register name##_eltype *arr = dst->arr;                       \
 									      \
 		/* move elements at i to i+n to preserve them */              \
-		memmove(arr+i+n, arr+i, (len-i)*elsz);                        \
+		MGA_MOVE_(arr+i+n, arr+i, (len-i)*elsz);                      \
+		MGA_STAT_(name, moved, (len-i)*elsz);                         \
 									      \
 		/* if src is NULL, caller will emplace, don't copy */         \
 		if (src)                                                      \
-			memcpy(arr+i, src, n*elsz);                           \
+			memcpy(arr+i, src, n*elsz),                           \
+			MGA_STAT_(name, copied, n*elsz);                      \
 									      \
 		dst->len = len+n;                                             \
 		return true;                                                  \
@@ -143,6 +271,52 @@ scope bool name##_insert(name *dst, size_t i,                                 \
 		return false;                                                 \
 }                                                                             \
 									      \
+/* Inserts k groups of elements, each as if by insert(dst, i, src, n),
+ * where i indexes arr as it was before the call.
+ * Groups must be sorted by i; groups with equal i are inserted in order.
+ * Reserves at most once and moves each element at most once.
+ */                                                                           \
+scope bool name##_insert_many(name *dst, const name##_ins *ins, size_t k)     \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	register size_t len, total = 0;                                       \
+	MGA_STAT_(name, insert_many, 1);                                      \
+	if (!dst || (k && !ins))                                              \
+		return false;                                                 \
+									      \
+	len = dst->len;                                                       \
+	for (size_t g = 0; g < k; g++)                                        \
+		if (ins[g].i > len || (g && ins[g].i < ins[g-1].i)            \
+				|| name##_maxcap-len-total < ins[g].n)        \
+			return false;                                         \
+		else                                                          \
+			total += ins[g].n;                                    \
+									      \
+	if (total && name##_reserve(dst, len+total)) {                        \
+		register name##_eltype *arr = dst->arr;                       \
+		register size_t end = len;                                    \
+									      \
+		dst->len = len+total;                                         \
+		/* Back to front, move elements at [i, end) to their final
+		 * place, total ahead, then fill the group in before them.
+		 */                                                           \
+		for (size_t g = k; g--; end = ins[g].i) {                     \
+			MGA_MOVE_(arr+ins[g].i+total, arr+ins[g].i,           \
+					(end-ins[g].i)*elsz);                 \
+			MGA_STAT_(name, moved, (end-ins[g].i)*elsz);          \
+			total -= ins[g].n;                                    \
+			/* if src is NULL, caller will emplace, don't copy */ \
+			if (ins[g].src)                                       \
+				memcpy(arr+ins[g].i+total, ins[g].src,        \
+						ins[g].n*elsz),               \
+				MGA_STAT_(name, copied, ins[g].n*elsz);       \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return !total;                                                \
+}                                                                             \
+									      \
 scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
 {                                                                             \
 	enum { elsz = sizeof(name##_eltype) };                                \
@@ -150,17 +324,20 @@ scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
 	if (!n)                                                               \
 		return true;                                                  \
 									      \
+	MGA_STAT_(name, selfinsert, 1);                                       \
 	register size_t len;                                                  \
 	if (foo && name##_maxcap-n >= (len = foo->len) && idst <= len         \
 		&& isrc < len && name##_reserve(foo, len+n)) {                \
 		register name##_eltype *arr = foo->arr;                       \
 									      \
-		memmove(arr+idst+n, arr+idst, (len-idst)*elsz);               \
+		MGA_MOVE_(arr+idst+n, arr+idst, (len-idst)*elsz);             \
 		/* If idst < isrc, isrc has moved n ahead.
 		 * If idst == isrc, don't copy.
 		 */                                                           \
-		memmove(arr+idst, arr+isrc + (idst < isrc)*n,                 \
+		MGA_MOVE_(arr+idst, arr+isrc + (idst < isrc)*n,               \
 				n*elsz * (idst != isrc));                     \
+		MGA_STAT_(name, moved,                                        \
+				(len-idst)*elsz + n*elsz*(idst != isrc));     \
 									      \
 		foo->len = len+n;                                             \
 		return true;                                                  \
@@ -172,11 +349,13 @@ scope bool name##_remove(name *dst, size_t i, size_t n)                       \
 {                                                                             \
 	enum { elsz = sizeof(name##_eltype) };                                \
 									      \
+	MGA_STAT_(name, remove, 1);                                           \
 	register name m;                                                      \
 	if (dst && name##_maxcap-i >= n && i+n <= (m = *dst).len) {           \
 									      \
 		/* Shift elements at index > i one step back */               \
-		memmove(m.arr+i, m.arr+i+n, (m.len-i-n)*elsz);                \
+		MGA_MOVE_(m.arr+i, m.arr+i+n, (m.len-i-n)*elsz);              \
+		MGA_STAT_(name, moved, (m.len-i-n)*elsz);                     \
 									      \
 		dst->len = m.len-n;                                           \
 		return true;                                                  \
@@ -184,16 +363,59 @@ scope bool name##_remove(name *dst, size_t i, size_t n)                       \
 		return false;                                                 \
 }                                                                             \
 									      \
+/* Removes elements for which pred(&arr[i], ctx) is true,
+ * returning how many were removed.
+ */                                                                           \
+scope size_t name##_remove_if(name *foo,                                      \
+		bool (*pred)(const name##_eltype *, void *ctx), void *ctx)    \
+{                                                                             \
+	MGA_REMOVE_IF_BODY_(name, pred)                                       \
+}                                                                             \
+									      \
+/* Removes k ranges of elements, where .i indexes arr as it was before
+ * the call. Ranges must be sorted by .i and not overlap.
+ * Moves each kept element at most once.
+ */                                                                           \
+scope bool name##_remove_many(name *dst, const name##_range *r, size_t k)     \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	MGA_STAT_(name, remove_many, 1);                                      \
+	if (!dst || (k && !r))                                                \
+		return false;                                                 \
+									      \
+	register name m = *dst;                                               \
+	for (size_t g = 0; g < k; g++)                                        \
+		if (name##_maxcap-r[g].i < r[g].n || r[g].i+r[g].n > m.len    \
+			|| (g && r[g].i < r[g-1].i+r[g-1].n))                 \
+			return false;                                         \
+									      \
+	register size_t w = k? r[0].i : m.len;                                \
+	for (size_t g = 0; g < k; g++) {                                      \
+		/* Shift elements between this range and the next back */    \
+		register size_t from = r[g].i+r[g].n;                         \
+		register size_t to = g+1 < k ? r[g+1].i : m.len;              \
+		MGA_MOVE_(m.arr+w, m.arr+from, (to-from)*elsz);               \
+		MGA_STAT_(name, moved, (to-from)*elsz);                       \
+		w += to-from;                                                 \
+	}                                                                     \
+	dst->len = w;                                                         \
+	return true;                                                          \
+}                                                                             \
+									      \
 scope void name##_shrink_to_fit(name *foo)                                    \
 {                                                                             \
 	enum { elsz = sizeof(name##_eltype) };                                \
 									      \
+	MGA_STAT_(name, shrink_to_fit, 1);                                    \
 	/* Avoid reallocation if not needed */                                \
 	register name m;                                                      \
 	if (foo && (m = *foo).cap > m.len) {                                  \
-		void *p = name##_realloc(m.arr, m.len*elsz);                  \
+		void *p = darc_realloc(m.alloc, name##_realloc,               \
+				m.arr, m.cap*elsz, m.len*elsz);               \
 		if (p)                                                        \
-			foo->arr = p, foo->cap = m.len;                       \
+			foo->arr = p, foo->cap = m.len,                       \
+			MGA_STAT_(name, reallocs, 1);                         \
 	}                                                                     \
 }                                                                             \
 
@@ -0,0 +1,149 @@
+#ifndef MGAIO_H
+#define MGAIO_H
+
+#include <stdbool.h> /* bool, true, false                 */
+#include <stddef.h>  /* size_t                            */
+#include <errno.h>   /* errno, EINTR, EINVAL, EIO, ENOMEM */
+#include <limits.h>  /* SSIZE_MAX, IOV_MAX                */
+#include <unistd.h>  /* read(), ssize_t                   */
+#include <sys/uio.h> /* writev(), struct iovec            */
+
+/* POSIX file descriptor I/O straight to and from an mga's arr,
+ * without a scratch buffer. All retry on EINTR and on partial transfers.
+ *
+ * MGA_IO_DEF(scope, name) expands, for a previously MGA_DECL()'d name :
+ *
+ * - size_t name_read(name *, int fd, size_t n)
+ *   Reserves n more elements, then reads into them at arr[len] until
+ *   n elements are read, end of file, or an error (including EAGAIN),
+ *   and grows len by the number of whole elements read.
+ *   Returns that number. If less than n, errno is 0 at end of file, or
+ *   else that of the error; or ENOMEM if it could not reserve.
+ *   The bytes of an element cut short are discarded, and errno is EIO
+ *   if that was due to end of file.
+ *
+ * - bool name_write(const name *, int fd, size_t i, size_t n)
+ *   Writes n elements from arr[i] onwards to fd.
+ *   Returns true if all were written, else false and sets errno.
+ *
+ * - bool name_writev(const name *, int fd, const name_range *r, size_t k)
+ *   Writes k ranges of elements to fd in order, gathered with writev().
+ *   Returns true if all were written, else false and sets errno,
+ *   to EINVAL if a range is out of bounds.
+ *
+ * Example : MGA_IO_DEF(static, bytes)
+ */
+
+#ifndef SSIZE_MAX
+#define SSIZE_MAX ((size_t)-1 / 2)
+#endif
+#ifndef IOV_MAX
+#define IOV_MAX 16 /* The least POSIX allows */
+#endif
+
+enum { MGAIO_IOVBATCH = IOV_MAX < 64 ? IOV_MAX : 64 }; /* iovecs/writev() */
+
+/* Reads up to sz bytes to dst, returns how many. Sets errno as name_read() */
+static inline size_t mgaio_read_(int fd, unsigned char *dst, size_t sz)
+{
+	register size_t got = 0;
+
+	errno = 0;
+	while (got < sz) {
+		ssize_t r = read(fd, dst+got,
+				sz-got > SSIZE_MAX ? SSIZE_MAX : sz-got);
+		if (r > 0)
+			got += r;
+		else if (r < 0 && errno == EINTR)
+			errno = 0;
+		else /* End of file, or error */
+			break;
+	}
+	return got;
+}
+
+/* Writes the cnt buffers of iov in full, adjusting them as it goes */
+static inline bool mgaio_writeiov_(int fd, struct iovec *iov, int cnt)
+{
+	while (cnt) {
+		ssize_t w = writev(fd, iov, cnt);
+		if (w < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		/* Skip what was written, resume partway through a buffer */
+		for (; cnt && (size_t)w >= iov->iov_len; iov++, cnt--)
+			w -= iov->iov_len;
+		if (cnt)
+			iov->iov_base = (unsigned char *)iov->iov_base + w,
+			iov->iov_len -= w;
+	}
+	return true;
+}
+
+#define MGA_IO_DEF(scope, name)                                               \
+scope size_t name##_read(name *foo, int fd, size_t n)                         \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return 0;                                                     \
+	if (!foo || name##_maxcap-n < foo->len                                \
+			|| !name##_reserve(foo, foo->len+n)) {                \
+		errno = ENOMEM;                                               \
+		return 0;                                                     \
+	}                                                                     \
+	register size_t got = mgaio_read_(fd,                                 \
+			(unsigned char *)(foo->arr+foo->len), n*elsz);        \
+	if (got % elsz && !errno)                                             \
+		errno = EIO;                                                  \
+									      \
+	foo->len += got/elsz;                                                 \
+	return got/elsz;                                                      \
+}                                                                             \
+									      \
+scope bool name##_writev(const name *foo, int fd, const name##_range *r,      \
+		size_t k)                                                     \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!foo) {                                                           \
+		errno = EINVAL;                                               \
+		return false;                                                 \
+	}                                                                     \
+	register size_t len = foo->len;                                       \
+	struct iovec iov[MGAIO_IOVBATCH];                                     \
+	int cnt = 0;                                                          \
+									      \
+	for (size_t g = 0; g < k; g++) {                                      \
+		if (r[g].i > len || r[g].n > len-r[g].i) {                    \
+			errno = EINVAL;                                       \
+			return false;                                         \
+		}                                                             \
+		/* Split ranges too large for one writev() */                 \
+		register unsigned char *p =                                   \
+			(unsigned char *)(foo->arr+r[g].i);                   \
+		register size_t sz = r[g].n*elsz;                             \
+		while (sz) {                                                  \
+			register size_t run = sz > SSIZE_MAX/MGAIO_IOVBATCH ? \
+				SSIZE_MAX/MGAIO_IOVBATCH : sz;                \
+			iov[cnt++] = (struct iovec){p, run};                  \
+			p += run, sz -= run;                                  \
+			if (cnt == MGAIO_IOVBATCH) {                          \
+				if (!mgaio_writeiov_(fd, iov, cnt))           \
+					return false;                         \
+				cnt = 0;                                      \
+			}                                                     \
+		}                                                             \
+	}                                                                     \
+	return mgaio_writeiov_(fd, iov, cnt);                                 \
+}                                                                             \
+									      \
+scope bool name##_write(const name *foo, int fd, size_t i, size_t n)          \
+{                                                                             \
+	name##_range r = {i, n};                                              \
+	return name##_writev(foo, fd, &r, 1);                                 \
+}                                                                             \
+
+#endif
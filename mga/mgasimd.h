@@ -0,0 +1,418 @@
+#ifndef MGASIMD_H
+#define MGASIMD_H
+
+#include <stdbool.h> /* bool, true, false        */
+#include <stddef.h>  /* size_t                   */
+#include <stdint.h>  /* int32_t, uint64_t, etc.  */
+#include <string.h>  /* memcpy()                 */
+
+/* Vectorised searches of arrays of scalars, and their mga bindings.
+ *
+ * MGA_SEARCH_DEF(scope, name, kind) expands, for a previously MGA_DECL()'d
+ * name whose element type is that of kind :
+ *
+ * - size_t name_find(const name *, name_eltype x)
+ *   Returns the index of the first element == x, or len if there is none.
+ * - size_t name_count(const name *, name_eltype x)
+ *   Returns the number of elements == x.
+ * - bool name_contains(const name *, name_eltype x)
+ * - bool name_min(const name *, name_eltype *min)
+ * - bool name_max(const name *, name_eltype *max)
+ *   Set *min or *max to the least or greatest element,
+ *   or return false if there are none.
+ *
+ * Where "kind" is one of,
+ * - i32, u32, i64, u64 for int32_t, uint32_t, int64_t, uint64_t.
+ * - f32, f64 for float, double.
+ *   As == goes, NaN is never found and -0.0 is found as 0.0.
+ *   min and max of arrays with NaNs are unspecified.
+ *
+ * Example : MGA_SEARCH_DEF(static, idvec, u32)
+ *
+ * The mgasimd_find_kind(), _count_kind(), _min_kind(), _max_kind()
+ * functions they call work on any array, the last two only if n > 0.
+ *
+ * On x86 with GCC or Clang, they use AVX2 if the CPU has it, checked at
+ * run time, else SSE2; elsewhere, or if MGASIMD_SCALAR is defined, loops
+ * left for the compiler to vectorise.
+ */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define MGASIMD_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define MGASIMD_UNUSED __attribute__((unused))
+#else
+	#define MGASIMD_UNUSED
+#endif
+
+#if !defined MGASIMD_SCALAR && defined __GNUC__ \
+	&& (defined __x86_64__ || (defined __i386__ && defined __SSE2__))
+	#define MGASIMD_X86 1
+	#include <immintrin.h>
+	#define MGASIMD_AVX2 __attribute__((target("avx2")))
+#else
+	#define MGASIMD_X86 0
+#endif
+
+/* ---- Kernel templates ----
+ *
+ * For element type T, vectors VT of W lanes, LOAD(p) loading W elements
+ * from p, SET1(x) broadcasting x, EQMASK(v, vx) giving the lanes of v
+ * equal to those of vx as bits, and OP(a, b) the lane-wise min or max.
+ * "attr" is the function's target attribute, if any.
+ */
+
+static inline unsigned mgasimd_ctz_(unsigned m)
+{
+#if defined __GNUC__
+	return __builtin_ctz(m);
+#else
+	unsigned r = 0;
+	for (; !(m & 1); m >>= 1)
+		r++;
+	return r;
+#endif
+}
+
+/* Number of set bits in m < 256 */
+static inline unsigned mgasimd_pop_(unsigned m)
+{
+	static const unsigned char nib[16] = {0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4};
+	return nib[m & 15] + nib[m >> 4];
+}
+
+#define MGASIMD_FIND_(fn, attr, T, VT, W, LOAD, SET1, EQMASK)                 \
+MGASIMD_UNUSED attr static size_t fn(const T *a, size_t n, T x)               \
+{                                                                             \
+	register size_t i = 0;                                                \
+	register VT vx = SET1(x);                                             \
+									      \
+	/* 4 vectors per step, only picking the lane once one matches */      \
+	for (; n-i >= 4*W; i += 4*W) {                                        \
+		unsigned m = EQMASK(LOAD(a+i), vx)                            \
+			| EQMASK(LOAD(a+i+W), vx) << W                        \
+			| EQMASK(LOAD(a+i+2*W), vx) << 2*W                    \
+			| EQMASK(LOAD(a+i+3*W), vx) << 3*W;                   \
+		if (m)                                                        \
+			return i + mgasimd_ctz_(m);                           \
+	}                                                                     \
+	for (; n-i >= W; i += W) {                                            \
+		unsigned m = EQMASK(LOAD(a+i), vx);                           \
+		if (m)                                                        \
+			return i + mgasimd_ctz_(m);                           \
+	}                                                                     \
+	for (; i < n; i++)                                                    \
+		if (a[i] == x)                                                \
+			return i;                                             \
+	return n;                                                             \
+}
+
+#define MGASIMD_COUNT_(fn, attr, T, VT, W, LOAD, SET1, EQMASK)                \
+MGASIMD_UNUSED attr static size_t fn(const T *a, size_t n, T x)               \
+{                                                                             \
+	register size_t i = 0, c = 0;                                         \
+	register VT vx = SET1(x);                                             \
+									      \
+	for (; n-i >= W; i += W)                                              \
+		c += mgasimd_pop_(EQMASK(LOAD(a+i), vx));                     \
+	for (a += i, n -= i; n--; a++)                                        \
+		c += *a == x;                                                 \
+	return c;                                                             \
+}
+
+/* "better" is < for min, > for max */
+#define MGASIMD_REDUCE_(fn, attr, T, VT, W, LOAD, OP, better)                 \
+MGASIMD_UNUSED attr static T fn(const T *a, size_t n)                         \
+{                                                                             \
+	register size_t i = 0;                                                \
+	T r = a[0];                                                           \
+									      \
+	if (n >= W) {                                                         \
+		VT acc = LOAD(a);                                             \
+		for (i = W; n-i >= W; i += W)                                 \
+			acc = OP(acc, LOAD(a+i));                             \
+		T lane[W];                                                    \
+		memcpy(lane, &acc, sizeof lane);                              \
+		r = lane[0];                                                  \
+		for (size_t l = 1; l < W; l++)                                \
+			if (lane[l] better r)                                 \
+				r = lane[l];                                  \
+	}                                                                     \
+	for (a += i, n -= i; n--; a++)                                        \
+		if (*a better r)                                              \
+			r = *a;                                               \
+	return r;                                                             \
+}
+
+/* Scalar vectors of 1 lane, for the portable fallback */
+#define MGASIMD_SLOAD_(p)    (*(p))
+#define MGASIMD_SSET1_(x)    (x)
+#define MGASIMD_SEQ_(v, vx)  ((unsigned)((v) == (vx)))
+#define MGASIMD_SMIN_(a, b)  ((b) < (a) ? (b) : (a))
+#define MGASIMD_SMAX_(a, b)  ((b) > (a) ? (b) : (a))
+
+#define MGASIMD_SCALAR_(pre, kind, T)                                         \
+	MGASIMD_FIND_(pre##find_##kind, , T, T, 1,                            \
+		MGASIMD_SLOAD_, MGASIMD_SSET1_, MGASIMD_SEQ_)                 \
+	MGASIMD_COUNT_(pre##count_##kind, , T, T, 1,                          \
+		MGASIMD_SLOAD_, MGASIMD_SSET1_, MGASIMD_SEQ_)                 \
+	MGASIMD_REDUCE_(pre##min_##kind, , T, T, 1,                           \
+		MGASIMD_SLOAD_, MGASIMD_SMIN_, <)                             \
+	MGASIMD_REDUCE_(pre##max_##kind, , T, T, 1,                           \
+		MGASIMD_SLOAD_, MGASIMD_SMAX_, >)
+
+MGASIMD_SCALAR_(mgasimd_scalar_, i32, int32_t)
+MGASIMD_SCALAR_(mgasimd_scalar_, u32, uint32_t)
+MGASIMD_SCALAR_(mgasimd_scalar_, i64, int64_t)
+MGASIMD_SCALAR_(mgasimd_scalar_, u64, uint64_t)
+MGASIMD_SCALAR_(mgasimd_scalar_, f32, float)
+MGASIMD_SCALAR_(mgasimd_scalar_, f64, double)
+
+#if MGASIMD_X86
+
+/* ---- SSE2 ---- */
+
+#define MGASIMD_SSE2_LOADI_(p) _mm_loadu_si128((const __m128i *)(p))
+#define MGASIMD_SSE2_EQ32_(v, vx)                                             \
+	((unsigned)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, vx))))
+/* Without pcmpeqq, both 32-bit halves of a lane must match */
+static inline unsigned mgasimd_sse2_eq64_(__m128i v, __m128i vx)
+{
+	__m128i c = _mm_cmpeq_epi32(v, vx);
+	c = _mm_and_si128(c, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_movemask_pd(_mm_castsi128_pd(c));
+}
+#define MGASIMD_SSE2_EQF32_(v, vx) ((unsigned)_mm_movemask_ps(_mm_cmpeq_ps(v, vx)))
+#define MGASIMD_SSE2_EQF64_(v, vx) ((unsigned)_mm_movemask_pd(_mm_cmpeq_pd(v, vx)))
+
+/* Without pminsd/pminud, select by compare, unsigned with signs flipped */
+static inline __m128i mgasimd_sse2_sel_(__m128i gt, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(gt, a), _mm_andnot_si128(gt, b));
+}
+static inline __m128i mgasimd_sse2_mini32_(__m128i a, __m128i b)
+{
+	return mgasimd_sse2_sel_(_mm_cmpgt_epi32(a, b), b, a);
+}
+static inline __m128i mgasimd_sse2_maxi32_(__m128i a, __m128i b)
+{
+	return mgasimd_sse2_sel_(_mm_cmpgt_epi32(a, b), a, b);
+}
+static inline __m128i mgasimd_sse2_minu32_(__m128i a, __m128i b)
+{
+	__m128i s = _mm_set1_epi32(INT32_MIN);
+	__m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(a, s), _mm_xor_si128(b, s));
+	return mgasimd_sse2_sel_(gt, b, a);
+}
+static inline __m128i mgasimd_sse2_maxu32_(__m128i a, __m128i b)
+{
+	__m128i s = _mm_set1_epi32(INT32_MIN);
+	__m128i gt = _mm_cmpgt_epi32(_mm_xor_si128(a, s), _mm_xor_si128(b, s));
+	return mgasimd_sse2_sel_(gt, a, b);
+}
+
+#define MGASIMD_SSE2_SET1I32_(x) _mm_set1_epi32((int32_t)(x))
+#define MGASIMD_SSE2_SET1I64_(x) _mm_set1_epi64x((int64_t)(x))
+
+MGASIMD_FIND_(mgasimd_sse2_find_u32, , uint32_t, __m128i, 4,
+	MGASIMD_SSE2_LOADI_, MGASIMD_SSE2_SET1I32_, MGASIMD_SSE2_EQ32_)
+MGASIMD_COUNT_(mgasimd_sse2_count_u32, , uint32_t, __m128i, 4,
+	MGASIMD_SSE2_LOADI_, MGASIMD_SSE2_SET1I32_, MGASIMD_SSE2_EQ32_)
+MGASIMD_FIND_(mgasimd_sse2_find_u64, , uint64_t, __m128i, 2,
+	MGASIMD_SSE2_LOADI_, MGASIMD_SSE2_SET1I64_, mgasimd_sse2_eq64_)
+MGASIMD_COUNT_(mgasimd_sse2_count_u64, , uint64_t, __m128i, 2,
+	MGASIMD_SSE2_LOADI_, MGASIMD_SSE2_SET1I64_, mgasimd_sse2_eq64_)
+MGASIMD_FIND_(mgasimd_sse2_find_f32, , float, __m128, 4,
+	_mm_loadu_ps, _mm_set1_ps, MGASIMD_SSE2_EQF32_)
+MGASIMD_COUNT_(mgasimd_sse2_count_f32, , float, __m128, 4,
+	_mm_loadu_ps, _mm_set1_ps, MGASIMD_SSE2_EQF32_)
+MGASIMD_FIND_(mgasimd_sse2_find_f64, , double, __m128d, 2,
+	_mm_loadu_pd, _mm_set1_pd, MGASIMD_SSE2_EQF64_)
+MGASIMD_COUNT_(mgasimd_sse2_count_f64, , double, __m128d, 2,
+	_mm_loadu_pd, _mm_set1_pd, MGASIMD_SSE2_EQF64_)
+
+MGASIMD_REDUCE_(mgasimd_sse2_min_i32, , int32_t, __m128i, 4,
+	MGASIMD_SSE2_LOADI_, mgasimd_sse2_mini32_, <)
+MGASIMD_REDUCE_(mgasimd_sse2_max_i32, , int32_t, __m128i, 4,
+	MGASIMD_SSE2_LOADI_, mgasimd_sse2_maxi32_, >)
+MGASIMD_REDUCE_(mgasimd_sse2_min_u32, , uint32_t, __m128i, 4,
+	MGASIMD_SSE2_LOADI_, mgasimd_sse2_minu32_, <)
+MGASIMD_REDUCE_(mgasimd_sse2_max_u32, , uint32_t, __m128i, 4,
+	MGASIMD_SSE2_LOADI_, mgasimd_sse2_maxu32_, >)
+MGASIMD_REDUCE_(mgasimd_sse2_min_f32, , float, __m128, 4,
+	_mm_loadu_ps, _mm_min_ps, <)
+MGASIMD_REDUCE_(mgasimd_sse2_max_f32, , float, __m128, 4,
+	_mm_loadu_ps, _mm_max_ps, >)
+MGASIMD_REDUCE_(mgasimd_sse2_min_f64, , double, __m128d, 2,
+	_mm_loadu_pd, _mm_min_pd, <)
+MGASIMD_REDUCE_(mgasimd_sse2_max_f64, , double, __m128d, 2,
+	_mm_loadu_pd, _mm_max_pd, >)
+
+/* ---- AVX2 ---- */
+
+#define MGASIMD_AVX2_LOADI_(p) _mm256_loadu_si256((const __m256i *)(p))
+#define MGASIMD_AVX2_SET1I32_(x) _mm256_set1_epi32((int32_t)(x))
+#define MGASIMD_AVX2_SET1I64_(x) _mm256_set1_epi64x((int64_t)(x))
+#define MGASIMD_AVX2_EQ32_(v, vx) ((unsigned)_mm256_movemask_ps(              \
+	_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, vx))))
+#define MGASIMD_AVX2_EQ64_(v, vx) ((unsigned)_mm256_movemask_pd(              \
+	_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, vx))))
+#define MGASIMD_AVX2_EQF32_(v, vx)                                            \
+	((unsigned)_mm256_movemask_ps(_mm256_cmp_ps(v, vx, _CMP_EQ_OQ)))
+#define MGASIMD_AVX2_EQF64_(v, vx)                                            \
+	((unsigned)_mm256_movemask_pd(_mm256_cmp_pd(v, vx, _CMP_EQ_OQ)))
+
+/* Without vpminsq/vpminuq, select by compare, unsigned with signs flipped */
+MGASIMD_AVX2 static inline __m256i mgasimd_avx2_mini64_(__m256i a, __m256i b)
+{
+	return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+MGASIMD_AVX2 static inline __m256i mgasimd_avx2_maxi64_(__m256i a, __m256i b)
+{
+	return _mm256_blendv_epi8(b, a, _mm256_cmpgt_epi64(a, b));
+}
+MGASIMD_AVX2 static inline __m256i mgasimd_avx2_minu64_(__m256i a, __m256i b)
+{
+	__m256i s = _mm256_set1_epi64x(INT64_MIN);
+	__m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(a, s),
+			_mm256_xor_si256(b, s));
+	return _mm256_blendv_epi8(a, b, gt);
+}
+MGASIMD_AVX2 static inline __m256i mgasimd_avx2_maxu64_(__m256i a, __m256i b)
+{
+	__m256i s = _mm256_set1_epi64x(INT64_MIN);
+	__m256i gt = _mm256_cmpgt_epi64(_mm256_xor_si256(a, s),
+			_mm256_xor_si256(b, s));
+	return _mm256_blendv_epi8(b, a, gt);
+}
+
+MGASIMD_FIND_(mgasimd_avx2_find_u32, MGASIMD_AVX2, uint32_t, __m256i, 8,
+	MGASIMD_AVX2_LOADI_, MGASIMD_AVX2_SET1I32_, MGASIMD_AVX2_EQ32_)
+MGASIMD_COUNT_(mgasimd_avx2_count_u32, MGASIMD_AVX2, uint32_t, __m256i, 8,
+	MGASIMD_AVX2_LOADI_, MGASIMD_AVX2_SET1I32_, MGASIMD_AVX2_EQ32_)
+MGASIMD_FIND_(mgasimd_avx2_find_u64, MGASIMD_AVX2, uint64_t, __m256i, 4,
+	MGASIMD_AVX2_LOADI_, MGASIMD_AVX2_SET1I64_, MGASIMD_AVX2_EQ64_)
+MGASIMD_COUNT_(mgasimd_avx2_count_u64, MGASIMD_AVX2, uint64_t, __m256i, 4,
+	MGASIMD_AVX2_LOADI_, MGASIMD_AVX2_SET1I64_, MGASIMD_AVX2_EQ64_)
+MGASIMD_FIND_(mgasimd_avx2_find_f32, MGASIMD_AVX2, float, __m256, 8,
+	_mm256_loadu_ps, _mm256_set1_ps, MGASIMD_AVX2_EQF32_)
+MGASIMD_COUNT_(mgasimd_avx2_count_f32, MGASIMD_AVX2, float, __m256, 8,
+	_mm256_loadu_ps, _mm256_set1_ps, MGASIMD_AVX2_EQF32_)
+MGASIMD_FIND_(mgasimd_avx2_find_f64, MGASIMD_AVX2, double, __m256d, 4,
+	_mm256_loadu_pd, _mm256_set1_pd, MGASIMD_AVX2_EQF64_)
+MGASIMD_COUNT_(mgasimd_avx2_count_f64, MGASIMD_AVX2, double, __m256d, 4,
+	_mm256_loadu_pd, _mm256_set1_pd, MGASIMD_AVX2_EQF64_)
+
+MGASIMD_REDUCE_(mgasimd_avx2_min_i32, MGASIMD_AVX2, int32_t, __m256i, 8,
+	MGASIMD_AVX2_LOADI_, _mm256_min_epi32, <)
+MGASIMD_REDUCE_(mgasimd_avx2_max_i32, MGASIMD_AVX2, int32_t, __m256i, 8,
+	MGASIMD_AVX2_LOADI_, _mm256_max_epi32, >)
+MGASIMD_REDUCE_(mgasimd_avx2_min_u32, MGASIMD_AVX2, uint32_t, __m256i, 8,
+	MGASIMD_AVX2_LOADI_, _mm256_min_epu32, <)
+MGASIMD_REDUCE_(mgasimd_avx2_max_u32, MGASIMD_AVX2, uint32_t, __m256i, 8,
+	MGASIMD_AVX2_LOADI_, _mm256_max_epu32, >)
+MGASIMD_REDUCE_(mgasimd_avx2_min_i64, MGASIMD_AVX2, int64_t, __m256i, 4,
+	MGASIMD_AVX2_LOADI_, mgasimd_avx2_mini64_, <)
+MGASIMD_REDUCE_(mgasimd_avx2_max_i64, MGASIMD_AVX2, int64_t, __m256i, 4,
+	MGASIMD_AVX2_LOADI_, mgasimd_avx2_maxi64_, >)
+MGASIMD_REDUCE_(mgasimd_avx2_min_u64, MGASIMD_AVX2, uint64_t, __m256i, 4,
+	MGASIMD_AVX2_LOADI_, mgasimd_avx2_minu64_, <)
+MGASIMD_REDUCE_(mgasimd_avx2_max_u64, MGASIMD_AVX2, uint64_t, __m256i, 4,
+	MGASIMD_AVX2_LOADI_, mgasimd_avx2_maxu64_, >)
+MGASIMD_REDUCE_(mgasimd_avx2_min_f32, MGASIMD_AVX2, float, __m256, 8,
+	_mm256_loadu_ps, _mm256_min_ps, <)
+MGASIMD_REDUCE_(mgasimd_avx2_max_f32, MGASIMD_AVX2, float, __m256, 8,
+	_mm256_loadu_ps, _mm256_max_ps, >)
+MGASIMD_REDUCE_(mgasimd_avx2_min_f64, MGASIMD_AVX2, double, __m256d, 4,
+	_mm256_loadu_pd, _mm256_min_pd, <)
+MGASIMD_REDUCE_(mgasimd_avx2_max_f64, MGASIMD_AVX2, double, __m256d, 4,
+	_mm256_loadu_pd, _mm256_max_pd, >)
+
+/* Equality of signed integers is that of their bits */
+#define MGASIMD_FORWARD_(op, kind, ukind, T, UT)                              \
+MGASIMD_UNUSED static size_t mgasimd_sse2_##op##_##kind(const T *a,           \
+		size_t n, T x)                                                \
+{ return mgasimd_sse2_##op##_##ukind((const UT *)a, n, (UT)x); }              \
+MGASIMD_UNUSED MGASIMD_AVX2 static size_t mgasimd_avx2_##op##_##kind(         \
+		const T *a, size_t n, T x)                                    \
+{ return mgasimd_avx2_##op##_##ukind((const UT *)a, n, (UT)x); }
+
+MGASIMD_FORWARD_(find, i32, u32, int32_t, uint32_t)
+MGASIMD_FORWARD_(count, i32, u32, int32_t, uint32_t)
+MGASIMD_FORWARD_(find, i64, u64, int64_t, uint64_t)
+MGASIMD_FORWARD_(count, i64, u64, int64_t, uint64_t)
+
+/* Without pcmpgtq, 64-bit min and max stay scalar under SSE2 */
+#define mgasimd_sse2_min_i64 mgasimd_scalar_min_i64
+#define mgasimd_sse2_max_i64 mgasimd_scalar_max_i64
+#define mgasimd_sse2_min_u64 mgasimd_scalar_min_u64
+#define mgasimd_sse2_max_u64 mgasimd_scalar_max_u64
+
+/* Calls the AVX2 or SSE2 kernel of name, as the CPU allows */
+#define MGASIMD_PICK_(name, args)                                             \
+	(__builtin_cpu_supports("avx2") ?                                     \
+		mgasimd_avx2_##name args : mgasimd_sse2_##name args)
+
+#else /* !MGASIMD_X86 */
+
+#define MGASIMD_PICK_(name, args) (mgasimd_scalar_##name args)
+
+#endif
+
+/* ---- Dispatchers ---- */
+
+#define MGASIMD_KIND_(kind, T)                                                \
+MGASIMD_UNUSED static inline size_t mgasimd_find_##kind(const T *a,           \
+		size_t n, T x)                                                \
+{ return MGASIMD_PICK_(find_##kind, (a, n, x)); }                             \
+MGASIMD_UNUSED static inline size_t mgasimd_count_##kind(const T *a,          \
+		size_t n, T x)                                                \
+{ return MGASIMD_PICK_(count_##kind, (a, n, x)); }                            \
+MGASIMD_UNUSED static inline T mgasimd_min_##kind(const T *a, size_t n)       \
+{ return MGASIMD_PICK_(min_##kind, (a, n)); }                                 \
+MGASIMD_UNUSED static inline T mgasimd_max_##kind(const T *a, size_t n)       \
+{ return MGASIMD_PICK_(max_##kind, (a, n)); }
+
+MGASIMD_KIND_(i32, int32_t)
+MGASIMD_KIND_(u32, uint32_t)
+MGASIMD_KIND_(i64, int64_t)
+MGASIMD_KIND_(u64, uint64_t)
+MGASIMD_KIND_(f32, float)
+MGASIMD_KIND_(f64, double)
+
+#define MGA_SEARCH_DEF(scope, name, kind)                                     \
+scope size_t name##_find(const name *foo, name##_eltype x)                    \
+{                                                                             \
+	return foo ? mgasimd_find_##kind(foo->arr, foo->len, x) : 0;          \
+}                                                                             \
+									      \
+scope size_t name##_count(const name *foo, name##_eltype x)                   \
+{                                                                             \
+	return foo ? mgasimd_count_##kind(foo->arr, foo->len, x) : 0;         \
+}                                                                             \
+									      \
+scope bool name##_contains(const name *foo, name##_eltype x)                  \
+{                                                                             \
+	return foo && mgasimd_find_##kind(foo->arr, foo->len, x) < foo->len;  \
+}                                                                             \
+									      \
+scope bool name##_min(const name *foo, name##_eltype *min)                    \
+{                                                                             \
+	if (foo && foo->len) {                                                \
+		*min = mgasimd_min_##kind(foo->arr, foo->len);                \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_max(const name *foo, name##_eltype *max)                    \
+{                                                                             \
+	if (foo && foo->len) {                                                \
+		*max = mgasimd_max_##kind(foo->arr, foo->len);                \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+
+#endif
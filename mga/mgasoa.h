@@ -0,0 +1,357 @@
+#ifndef MGASOA_H
+#define MGASOA_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+#include <stdint.h>  /* uintptr_t         */
+
+#include "mga.h" /* MGA_UNUSED, MGA_STATS_DECL_(), MGA_MOVE_, etc. */
+
+/* Struct of arrays : an mga of records kept as one column per field,
+ * so that loops over a field or two only fetch those fields.
+ *
+ * MGA_SOA_DECL(scope, name, ...) declares an instantiation as MGA_DECL()
+ * does, where "..." is a list of up to MGASOA_MAXCOLS "(type, field)"
+ * pairs, and "type" has no commas outside parentheses.
+ *
+ * Example : MGA_SOA_DECL(, particles, (float, x), (float, y), (int, id))
+ * Declares particles, a struct with a float *x, float *y and int *id.
+ *
+ * - Member types :
+ *   - name, with size_t len, cap; a pointer to the column of each field,
+ *     all of len elements and room for cap; void *block, the allocation
+ *     holding all columns; and const darc_allocator *alloc.
+ *   - name_row, a struct with a member of each field, of each type.
+ * - Member constants :
+ *   - name_maxcap, the maximum number of rows.
+ *   - name_realloc, name_free; aliases of reallocfn(),freefn().
+ *
+ * - Member functions :
+ *   - name_create(), name_create_with(), name_destroy(), name_reserve(),
+ *     name_selfinsert(), name_remove(), name_shrink_to_fit(), as for mga,
+ *     applied to every column.
+ *   - name_insert(), likewise, taking its n rows from a name_row array.
+ *   - name_get(), name_set(), which read and write row i as a name_row.
+ *   - name_field(), for each field, returning its column. Columns start
+ *     MGASOA_ALIGN aligned, which GCC and clang are told for vectorized
+ *     loops over them.
+ *
+ * All columns are allocated in one block. As their offsets in it depend on
+ * cap, resizing copies them to a new block, and frees the previous one.
+ * The columns of an instance with no cap may be NULL.
+ *
+ * MGA_SOA_DEF(scope, name, reallocfn, freefn, ...) defines the functions
+ * for previously MGA_SOA_DECL()'d name, with the same "...",
+ * and MGA_SOA_IMPL(name, reallocfn, freefn, ...) does both, as for mga.
+ */
+
+#ifndef MGASOA_ALIGN
+#define MGASOA_ALIGN 64 /* Alignment of each column, a power of 2 */
+#endif
+
+#if defined __GNUC__
+	#define MGASOA_ALIGNED_(p) __builtin_assume_aligned(p, MGASOA_ALIGN)
+#else
+	#define MGASOA_ALIGNED_(p) (p)
+#endif
+
+/* Rounds up sz, or address p, to a multiple of MGASOA_ALIGN */
+#define MGASOA_ROUND_(sz) (((sz) + MGASOA_ALIGN-1) & ~(size_t)(MGASOA_ALIGN-1))
+#define MGASOA_ROUNDP_(p)                                                     \
+	((unsigned char *)(p) + (-(uintptr_t)(p) & (MGASOA_ALIGN-1)))
+
+/* Expands m(name, type, field) for each "(type, field)" in "..." */
+#define MGASOA_MAXCOLS 16
+#define MGASOA_NCOLS_(...) MGASOA_NCOLS__(__VA_ARGS__,                        \
+	16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define MGASOA_NCOLS__(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12,     \
+	_13, _14, _15, _16, n, ...) n
+#define MGASOA_CAT_(a, b) MGASOA_CAT__(a, b)
+#define MGASOA_CAT__(a, b) a##b
+#define MGASOA_APPLY_(m, ...) m(__VA_ARGS__)
+#define MGASOA_UNPACK_(type, field) type, field
+#define MGASOA_ONE_(m, name, col) MGASOA_APPLY_(m, name, MGASOA_UNPACK_ col)
+#define MGASOA_EACH_(m, name, ...)                                            \
+	MGASOA_CAT_(MGASOA_EACH_, MGASOA_NCOLS_(__VA_ARGS__))                 \
+		(m, name, __VA_ARGS__)
+#define MGASOA_EACH_1(m, n, c) MGASOA_ONE_(m, n, c)
+#define MGASOA_EACH_2(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_1(m, n, __VA_ARGS__)
+#define MGASOA_EACH_3(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_2(m, n, __VA_ARGS__)
+#define MGASOA_EACH_4(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_3(m, n, __VA_ARGS__)
+#define MGASOA_EACH_5(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_4(m, n, __VA_ARGS__)
+#define MGASOA_EACH_6(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_5(m, n, __VA_ARGS__)
+#define MGASOA_EACH_7(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_6(m, n, __VA_ARGS__)
+#define MGASOA_EACH_8(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_7(m, n, __VA_ARGS__)
+#define MGASOA_EACH_9(m, n, c, ...)                                           \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_8(m, n, __VA_ARGS__)
+#define MGASOA_EACH_10(m, n, c, ...)                                          \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_9(m, n, __VA_ARGS__)
+#define MGASOA_EACH_11(m, n, c, ...)                                          \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_10(m, n, __VA_ARGS__)
+#define MGASOA_EACH_12(m, n, c, ...)                                          \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_11(m, n, __VA_ARGS__)
+#define MGASOA_EACH_13(m, n, c, ...)                                          \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_12(m, n, __VA_ARGS__)
+#define MGASOA_EACH_14(m, n, c, ...)                                          \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_13(m, n, __VA_ARGS__)
+#define MGASOA_EACH_15(m, n, c, ...)                                          \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_14(m, n, __VA_ARGS__)
+#define MGASOA_EACH_16(m, n, c, ...)                                          \
+	MGASOA_ONE_(m, n, c) MGASOA_EACH_15(m, n, __VA_ARGS__)
+
+/* Bytes of a row, summed over the columns */
+#define MGASOA_SIZE_(name, type, field) + sizeof(type)
+#define MGASOA_ROWSZ_(...) (0 MGASOA_EACH_(MGASOA_SIZE_, , __VA_ARGS__))
+
+#define MGASOA_MEMBER_(name, type, field) type *field;
+#define MGASOA_ROWMEMBER_(name, type, field) type field;
+#define MGASOA_ACCESSOR_(name, type, field)                                   \
+MGA_UNUSED static inline type *name##_##field(const name *foo)                \
+{                                                                             \
+	return MGASOA_ALIGNED_(foo->field);                                   \
+}
+
+#define MGA_SOA_DECL(scope, name, ...)                                        \
+typedef struct name {                                                         \
+	size_t len, cap;                                                      \
+	MGASOA_EACH_(MGASOA_MEMBER_, name, __VA_ARGS__)                       \
+	void *block;                                                          \
+	const darc_allocator *alloc;                                          \
+} name;                                                                       \
+typedef struct name##_row {                                                   \
+	MGASOA_EACH_(MGASOA_ROWMEMBER_, name, __VA_ARGS__)                    \
+} name##_row;                                                                 \
+									      \
+/* Leaves room to align each column, and the block */                         \
+MGA_UNUSED static const size_t name##_maxcap =                                \
+	(SIZE_MAX - (MGASOA_NCOLS_(__VA_ARGS__)+1)*MGASOA_ALIGN)              \
+	/ MGASOA_ROWSZ_(__VA_ARGS__);                                         \
+									      \
+MGASOA_EACH_(MGASOA_ACCESSOR_, name, __VA_ARGS__)                             \
+									      \
+scope name name##_create(size_t);                                             \
+scope name name##_create_with(size_t, const darc_allocator *alloc);           \
+scope void name##_destroy(name *);                                            \
+scope bool name##_reserve(name *, size_t);                                    \
+scope bool name##_insert(name *, size_t i, const name##_row *restrict src,    \
+								   size_t n); \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
+scope bool name##_remove(name *, size_t i, size_t n);                         \
+scope void name##_shrink_to_fit(name *);                                      \
+scope name##_row name##_get(const name *, size_t i);                          \
+scope void name##_set(name *, size_t i, name##_row);                          \
+MGA_STATS_DECL_(scope, name)                                                  \
+
+#ifndef MGA_NOIMPL
+
+#include <string.h> /* memcpy() */
+
+/* Statements on column field of foo or dst, expanded for each field */
+#define MGASOA_BLOCKSZ_(name, type, field) + MGASOA_ROUND_(cap*sizeof(type))
+#define MGASOA_PLACE_(name, type, field)                                      \
+	res.field = (type *)(p+off), off += MGASOA_ROUND_(cap*sizeof(type));
+#define MGASOA_COPY_(name, type, field)                                       \
+	memcpy(res.field, foo->field, res.len*sizeof(type));
+#define MGASOA_INSERT_(name, type, field)                                     \
+	MGA_MOVE_(dst->field+i+n, dst->field+i, (len-i)*sizeof(type));        \
+	if (src)                                                              \
+		for (size_t j = 0; j < n; j++)                                \
+			dst->field[i+j] = src[j].field;
+#define MGASOA_SELFINSERT_(name, type, field)                                 \
+	MGA_MOVE_(foo->field+idst+n, foo->field+idst,                         \
+			(len-idst)*sizeof(type));                             \
+	MGA_MOVE_(foo->field+idst, foo->field+isrc + (idst < isrc)*n,         \
+			n*sizeof(type) * (idst != isrc));
+#define MGASOA_REMOVE_(name, type, field)                                     \
+	MGA_MOVE_(dst->field+i, dst->field+i+n, (len-i-n)*sizeof(type));
+#define MGASOA_GET_(name, type, field) res.field = foo->field[i];
+#define MGASOA_SET_(name, type, field) foo->field[i] = r.field;
+
+#define MGA_SOA_DEF(scope, name, reallocfn, freefn, ...)                      \
+static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
+static void (*const name##_free)(void *) = freefn;                            \
+MGA_STATS_DEF_(scope, name)                                                   \
+									      \
+/* Size of the block for cap rows */                                          \
+static inline size_t name##_blocksz_(size_t cap)                              \
+{                                                                             \
+	return cap ? MGASOA_ALIGN-1                                           \
+		MGASOA_EACH_(MGASOA_BLOCKSZ_, name, __VA_ARGS__) : 0;         \
+}                                                                             \
+									      \
+/* Moves the columns of foo to a new block for cap rows, or frees it if
+ * cap is 0. Returns false, leaving foo as it was, if it can't allocate.
+ */                                                                           \
+static inline bool name##_relocate_(name *foo, size_t cap)                    \
+{                                                                             \
+	enum { rowsz = MGASOA_ROWSZ_(__VA_ARGS__) };                          \
+									      \
+	name res = {.len = foo->len, .cap = cap, .alloc = foo->alloc};        \
+	if (cap) {                                                            \
+		res.block = darc_realloc(foo->alloc, name##_realloc,          \
+				NULL, 0, name##_blocksz_(cap));               \
+		if (!res.block)                                               \
+			return false;                                         \
+									      \
+		register unsigned char *p = MGASOA_ROUNDP_(res.block);        \
+		register size_t off = 0;                                      \
+		MGASOA_EACH_(MGASOA_PLACE_, name, __VA_ARGS__)                \
+		if (foo->block) {                                             \
+			MGASOA_EACH_(MGASOA_COPY_, name, __VA_ARGS__)         \
+			MGA_STAT_(name, copied, res.len*rowsz);               \
+		}                                                             \
+		MGA_STAT_(name, reallocs, 1);                                 \
+		MGA_PEAK_(name, name##_blocksz_(cap));                        \
+	}                                                                     \
+	darc_free(foo->alloc, name##_free, foo->block,                        \
+			name##_blocksz_(foo->cap));                           \
+	*foo = res;                                                           \
+	return true;                                                          \
+}                                                                             \
+									      \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
+{                                                                             \
+	name res = {.alloc = alloc};                                          \
+	MGA_STAT_(name, create, 1);                                           \
+	if (n && n <= name##_maxcap)                                          \
+		(void)name##_relocate_(&res, n);                              \
+	return res;                                                           \
+}                                                                             \
+									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_with(n, NULL);                                   \
+}                                                                             \
+									      \
+/* Keeps the allocator, so foo may be reused. */                              \
+scope void name##_destroy(name *foo)                                          \
+{                                                                             \
+	MGA_STAT_(name, destroy, 1);                                          \
+	if (foo)                                                              \
+		darc_free(foo->alloc, name##_free, foo->block,                \
+				name##_blocksz_(foo->cap)),                   \
+		*foo = (name){.alloc = foo->alloc};                           \
+}                                                                             \
+									      \
+scope bool name##_reserve(name *foo, size_t n)                                \
+{                                                                             \
+	MGA_STAT_(name, reserve, 1);                                          \
+	if (foo && n <= name##_maxcap) {                                      \
+		register size_t cap = foo->cap;                               \
+									      \
+		if (cap < n) {                                                \
+			size_t newcap = cap+cap/2; /* Try growing 1.5x */     \
+			/* Or grow to n rows if its bigger or overflow */     \
+			if (newcap < n || newcap > name##_maxcap)             \
+				newcap = n;                                   \
+									      \
+			return name##_relocate_(foo, newcap);                 \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_insert(name *dst, size_t i,                                 \
+		const name##_row *restrict src, size_t n)                     \
+{                                                                             \
+	enum { rowsz = MGASOA_ROWSZ_(__VA_ARGS__) };                          \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	MGA_STAT_(name, insert, 1);                                           \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-n >= (len = dst->len) && i <= len            \
+			&& name##_reserve(dst, len+n)) {                      \
+		/* Per column, move rows at i to i+n to preserve them,
+		 * then copy src's fields in, unless it is NULL to emplace.
+		 */                                                           \
+		MGASOA_EACH_(MGASOA_INSERT_, name, __VA_ARGS__)               \
+		MGA_STAT_(name, moved, (len-i)*rowsz);                        \
+		if (src)                                                      \
+			MGA_STAT_(name, copied, n*rowsz);                     \
+									      \
+		dst->len = len+n;                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
+{                                                                             \
+	enum { rowsz = MGASOA_ROWSZ_(__VA_ARGS__) };                          \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	MGA_STAT_(name, selfinsert, 1);                                       \
+	register size_t len;                                                  \
+	if (foo && name##_maxcap-n >= (len = foo->len) && idst <= len         \
+		&& isrc < len && name##_reserve(foo, len+n)) {                \
+		/* Per column, as mga's selfinsert() :
+		 * if idst < isrc, isrc has moved n ahead,
+		 * if idst == isrc, don't copy.
+		 */                                                           \
+		MGASOA_EACH_(MGASOA_SELFINSERT_, name, __VA_ARGS__)           \
+		MGA_STAT_(name, moved,                                        \
+				(len-idst)*rowsz + n*rowsz*(idst != isrc));   \
+									      \
+		foo->len = len+n;                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_remove(name *dst, size_t i, size_t n)                       \
+{                                                                             \
+	enum { rowsz = MGASOA_ROWSZ_(__VA_ARGS__) };                          \
+									      \
+	MGA_STAT_(name, remove, 1);                                           \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-i >= n && i+n <= (len = dst->len)) {         \
+		/* Shift rows at index > i one step back, per column */       \
+		MGASOA_EACH_(MGASOA_REMOVE_, name, __VA_ARGS__)               \
+		MGA_STAT_(name, moved, (len-i-n)*rowsz);                      \
+									      \
+		dst->len = len-n;                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope void name##_shrink_to_fit(name *foo)                                    \
+{                                                                             \
+	MGA_STAT_(name, shrink_to_fit, 1);                                    \
+	/* Avoid reallocation if not needed */                                \
+	if (foo && foo->cap > foo->len)                                       \
+		(void)name##_relocate_(foo, foo->len);                        \
+}                                                                             \
+									      \
+/* UB if i >= len, as for indexing a column */                                \
+scope name##_row name##_get(const name *foo, size_t i)                        \
+{                                                                             \
+	name##_row res;                                                       \
+	MGASOA_EACH_(MGASOA_GET_, name, __VA_ARGS__)                          \
+	return res;                                                           \
+}                                                                             \
+									      \
+scope void name##_set(name *foo, size_t i, name##_row r)                      \
+{                                                                             \
+	MGASOA_EACH_(MGASOA_SET_, name, __VA_ARGS__)                          \
+}                                                                             \
+
+#define MGA_SOA_IMPL(name, reallocfn, freefn, ...)                            \
+	MGA_SOA_DECL(MGA_UNUSED static inline, name, __VA_ARGS__)             \
+	MGA_SOA_DEF(MGA_UNUSED static inline, name, reallocfn, freefn,        \
+			__VA_ARGS__)
+
+#endif
+#endif
@@ -0,0 +1,96 @@
+#ifndef MGASORT_H
+#define MGASORT_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+#include <string.h>  /* memcpy()          */
+
+#include "../sort/radix.h" /* RADIX_SORT_DEF_(), radix_key_*() */
+
+/* Stable radix sorts of mgas by integer or floating point keys,
+ * in O(len) time, with len elements of scratch space.
+ *
+ * MGA_SORT_DEF(scope, name, kind) expands, for a previously MGA_DECL()'d
+ * name whose element type is that of kind :
+ *
+ * - bool name_sort(name *)
+ *   Sorts the elements in ascending order.
+ *   Returns false, leaving them as they were, if it can't allocate.
+ *
+ * MGA_SORT_BY_DEF(scope, fn, name, kind, keyfn) defines
+ * "scope bool fn(name *)", which sorts the same way by keyfn(const
+ * name_eltype *), a function or function-like macro returning the key of
+ * an element, of the type of kind. Elements with equal keys keep their
+ * order.
+ *
+ * Where "kind" is one of,
+ * - u8, u16, u32, u64 for uint8_t, uint16_t, uint32_t, uint64_t.
+ * - i8, i16, i32, i64 for int8_t, int16_t, int32_t, int64_t.
+ * - f32, f64 for float, double.
+ *   Negative floats sort before positive ones, -0.0 before 0.0,
+ *   and NaNs after infinity or before -infinity, as per their sign.
+ *
+ * Example : MGA_SORT_DEF(static, idvec, u32)
+ *           MGA_SORT_BY_DEF(static, people_by_age, people, u8, AGE)
+ *           where #define AGE(p) ((p)->age)
+ *
+ * The scratch space is allocated as an mga of name with the instance's
+ * allocator, or with name_realloc if that fails, as it does when the
+ * allocator can only hold the instance's one block.
+ * Arrays of at least RADIX_PAR_MIN elements are sorted by several
+ * threads, unless RADIX_NOTHREADS is defined (see sort/radix.h).
+ */
+
+#define MGA_SORT_BODY_(name, radixfn)                                         \
+	if (!foo)                                                             \
+		return false;                                                 \
+	if (foo->len < 2)                                                     \
+		return true;                                                  \
+									      \
+	/* Insertion sort holds one element aside, radix sort moves all.
+	 * Try the instance's allocator first, which may only hold its block.
+	 */                                                                   \
+	size_t ntmp = foo->len < RADIX_SMALL ? 1 : foo->len;                  \
+	name tmp = name##_create_with(ntmp, foo->alloc);                      \
+	if (!tmp.arr && foo->alloc)                                           \
+		tmp = name##_create(ntmp);                                    \
+	if (!tmp.arr)                                                         \
+		return false;                                                 \
+	radixfn((unsigned char *)foo->arr, (unsigned char *)tmp.arr,          \
+			foo->len, sizeof(name##_eltype), NULL);               \
+	name##_destroy(&tmp);                                                 \
+	return true;                                                          \
+
+#define MGA_SORT_DEF(scope, name, kind)                                       \
+static inline radix_kt_##kind name##_sortkey_(const void *ctx,                \
+		const unsigned char *p)                                       \
+{                                                                             \
+	name##_eltype x;                                                      \
+	(void)ctx;                                                            \
+	memcpy(&x, p, sizeof x);                                              \
+	return radix_key_##kind(x);                                           \
+}                                                                             \
+RADIX_SORT_DEF_(name##_radix_, radix_kt_##kind, name##_sortkey_,              \
+		sizeof(name##_eltype))                                        \
+									      \
+scope bool name##_sort(name *foo)                                             \
+{                                                                             \
+	MGA_SORT_BODY_(name, name##_radix_)                                   \
+}                                                                             \
+
+#define MGA_SORT_BY_DEF(scope, fn, name, kind, keyfn)                         \
+static inline radix_kt_##kind fn##_sortkey_(const void *ctx,                  \
+		const unsigned char *p)                                       \
+{                                                                             \
+	(void)ctx;                                                            \
+	return radix_key_##kind(keyfn((const name##_eltype *)p));             \
+}                                                                             \
+RADIX_SORT_DEF_(fn##_radix_, radix_kt_##kind, fn##_sortkey_,                  \
+		sizeof(name##_eltype))                                        \
+									      \
+scope bool fn(name *foo)                                                      \
+{                                                                             \
+	MGA_SORT_BODY_(name, fn##_radix_)                                     \
+}                                                                             \
+
+#endif
@@ -0,0 +1,163 @@
+#include <stdbool.h> /* bool, true, false          */
+#include <stdlib.h>  /* malloc(), free()           */
+#include <string.h>  /* memcpy(), memmove()        */
+#include <pthread.h> /* pthread_*()                */
+#include <unistd.h>  /* sysconf()                  */
+#include "pmove.h"
+
+typedef unsigned char byte;
+
+/* One thread's share of a move : memmove() n bytes from src to dst,
+ * then copy k bytes set aside at stash to sdst.
+ */
+typedef struct part {
+	byte *dst; const byte *src; size_t n;
+	byte *sdst; const byte *stash; size_t k;
+} part;
+
+/* Workers wait on wake for parts, the caller on idle for them to finish */
+static struct {
+	pthread_mutex_t mu;
+	pthread_cond_t wake, idle;
+	const part *parts;
+	unsigned nparts, next, pending;
+	unsigned nthreads; /* Including the caller's */
+} pool = {
+	.mu = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER, .idle = PTHREAD_COND_INITIALIZER
+};
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t busy = PTHREAD_MUTEX_INITIALIZER; /* One at a time */
+
+/* Runs parts until none are left to take. Called with pool.mu held. */
+static void drain(void)
+{
+	while (pool.next < pool.nparts) {
+		const part *p = pool.parts + pool.next++;
+
+		pthread_mutex_unlock(&pool.mu);
+		memmove(p->dst, p->src, p->n);
+		if (p->k)
+			memcpy(p->sdst, p->stash, p->k);
+		pthread_mutex_lock(&pool.mu);
+
+		if (!--pool.pending)
+			pthread_cond_signal(&pool.idle);
+	}
+}
+
+static void *worker(void *arg)
+{
+	(void)arg;
+	pthread_mutex_lock(&pool.mu);
+	for (;;) {
+		drain();
+		pthread_cond_wait(&pool.wake, &pool.mu);
+	}
+	return NULL;
+}
+
+static void start(void)
+{
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned want = cpus < 1 ? 1
+		: cpus < PMOVE_THREADS ? (unsigned)cpus : PMOVE_THREADS;
+	pthread_t t;
+
+	for (pool.nthreads = 1; pool.nthreads < want; pool.nthreads++)
+		if (pthread_create(&t, NULL, worker, NULL))
+			break;
+		else
+			pthread_detach(t);
+}
+
+/* Runs the k parts over the pool and the calling thread */
+static void runall(const part *parts, unsigned k)
+{
+	pthread_mutex_lock(&pool.mu);
+	pool.parts = parts, pool.nparts = k;
+	pool.next = 0, pool.pending = k;
+	pthread_cond_broadcast(&pool.wake);
+
+	drain();
+	while (pool.pending)
+		pthread_cond_wait(&pool.idle, &pool.mu);
+	pthread_mutex_unlock(&pool.mu);
+}
+
+/* Moves n bytes that don't overlap, in t parts */
+static void split(byte *dst, const byte *src, size_t n, unsigned t)
+{
+	part parts[PMOVE_THREADS];
+
+	for (unsigned j = 0; j < t; j++) {
+		size_t lo = n/t*j, hi = j+1 == t ? n : n/t*(j+1);
+		parts[j] = (part){dst+lo, src+lo, hi-lo, NULL, NULL, 0};
+	}
+	runall(parts, t);
+}
+
+/* Moves n bytes a distance d < n/t, in t chunks. Each chunk's d bytes
+ * that the next (moving down) or previous (moving up) chunk overwrites
+ * are set aside first, and put in place after the rest of it is moved.
+ */
+static bool stashed(byte *dst, const byte *src, size_t n, size_t d,
+		unsigned t)
+{
+	part parts[PMOVE_THREADS];
+	byte *stash = malloc((t-1)*d);
+
+	if (!stash)
+		return false;
+	for (unsigned j = 0; j < t; j++) {
+		size_t lo = n/t*j, hi = j+1 == t ? n : n/t*(j+1);
+		if (dst < src && j+1 < t) { /* Tail overwritten by j+1 */
+			byte *s = stash + j*d;
+			memcpy(s, src + hi-d, d);
+			parts[j] = (part){dst+lo, src+lo, hi-lo-d,
+					dst + hi-d, s, d};
+		} else if (dst > src && j) { /* Head overwritten by j-1 */
+			byte *s = stash + (j-1)*d;
+			memcpy(s, src+lo, d);
+			parts[j] = (part){dst+lo+d, src+lo+d, hi-lo-d,
+					dst+lo, s, d};
+		} else
+			parts[j] = (part){dst+lo, src+lo, hi-lo,
+					NULL, NULL, 0};
+	}
+	runall(parts, t);
+	free(stash);
+	return true;
+}
+
+void *pmove(void *dst, const void *src, size_t n)
+{
+	if (n < PMOVE_MIN || dst == src)
+		return memmove(dst, src, n);
+
+	pthread_once(&once, start);
+	if (pool.nthreads < 2 || pthread_mutex_trylock(&busy))
+		return memmove(dst, src, n);
+
+	byte *d = dst;
+	const byte *s = src;
+	size_t dist = d < s ? (size_t)(s-d) : (size_t)(d-s);
+	unsigned t = pool.nthreads;
+
+	if (dist >= n)
+		split(d, s, n, t);
+	else if (dist >= n/t) /* In rounds of dist bytes, clear of the next */
+		for (size_t done = 0; done < n; ) {
+			size_t k = n-done < dist ? n-done : dist;
+			if (d < s)
+				split(d+done, s+done, k, t);
+			else
+				split(d + n-done-k, s + n-done-k, k, t);
+			done += k;
+		}
+	else if (!stashed(d, s, n, dist, t))
+		memmove(dst, src, n);
+
+	pthread_mutex_unlock(&busy);
+	return dst;
+}
@@ -0,0 +1,34 @@
+#ifndef PMOVE_H
+#define PMOVE_H
+
+#include <stddef.h> /* size_t */
+
+/* A memmove() that spreads very large moves over a small pool of threads,
+ * to use more of the memory bandwidth than one core can.
+ *
+ * Moves below PMOVE_MIN bytes, moves made while another is in progress,
+ * and all moves if threads can't be started, are plain memmove()s.
+ * Overlapping moves are split into chunks copied in an order that never
+ * overwrites bytes before they are read : the few bytes of each chunk
+ * that its neighbour would overwrite are set aside first, or if the
+ * distance moved is large, the move is made in rounds of that distance.
+ *
+ * Opt in by compiling vpa.c with VPA_PMOVE, or defining MGA_PMOVE before
+ * including mga/mga.h, and linking pmove.c with POSIX threads; so that
+ * insert(), remove(), selfinsert() and the like shift with pmove().
+ */
+
+/* Size in bytes from which moves are parallel, settable at compile time */
+#ifndef PMOVE_MIN
+#define PMOVE_MIN ((size_t)16 << 20)
+#endif
+
+/* Most threads a move uses, including the caller's */
+#ifndef PMOVE_THREADS
+#define PMOVE_THREADS 8
+#endif
+
+/* Follows stdlib memmove's ABI */
+void *pmove(void *dst, const void *src, size_t n);
+
+#endif
@@ -0,0 +1,343 @@
+#ifndef RGA_H
+#define RGA_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+
+#include "../alloc/allocator.h" /* darc_allocator */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define RGA_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define RGA_UNUSED __attribute__((unused))
+#else
+	#define RGA_UNUSED
+#endif
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+/* Declares a ring buffer deque instantiation with given name,
+ * scope and "..." element type.
+ *
+ * A ring deque keeps its elements in arr as a circle starting at head,
+ * so element i is at arr[(head+i) % cap] and may wrap past the end.
+ * An insertion or removal moves whichever side of it is shorter,
+ * so those at either end cost only copying the inserted elements,
+ * making it fit for FIFO queues, unlike mga.
+ * Growth unwraps the ring at most once, moving its shorter part.
+ *
+ * Where,
+ * - "scope" is empty or a valid prefix for a function declaration,
+ *   like static, inline, etc.
+ * - "name" is a valid identifier.
+ * - "..." is a type name such that a suffixed "*" creates
+ *   a pointer to that type.
+ *
+ * Example : RGA_DECL(, jobq, struct job)
+ * Declares jobq for struct jobs with functions in the global scope.
+ *
+ * An instance whose alloc is not NULL allocates with *alloc instead
+ * of the functions given to RGA_DEF(), and *alloc must outlive it.
+ *
+ * - Member types :
+ *   - name_eltype, the type of the elements (aka value_type).
+ *   - name_span, a contiguous run of n elements at p.
+ * - Member constants :
+ *   - name_maxcap, the maxmimum number of elements.
+ *   - name_realloc, name_free; aliases of reallocfn(),freefn().
+ *
+ * - Member functions :
+ *   - name_create()
+ *   - name_create_with(), which also sets the allocator alloc.
+ *   - name_destroy()
+ *   - name_reserve()
+ *   - name_insert()
+ *   - name_selfinsert()
+ *   - name_remove()
+ *   - name_shrink_to_fit()
+ *   - name_at(), returns pointer to element at given index.
+ *   - name_spans(), gives the elements in order as at most 2 spans.
+ */
+#define RGA_DECL(scope, name, ...)                                            \
+typedef __VA_ARGS__ name##_eltype;                                            \
+typedef struct name {                                                         \
+	size_t len, cap, head; name##_eltype *arr;                            \
+	const darc_allocator *alloc;                                          \
+} name;                                                                       \
+typedef struct name##_span { name##_eltype *p; size_t n; } name##_span;       \
+									      \
+RGA_UNUSED static const size_t name##_maxcap =                                \
+	SIZE_MAX/sizeof(name##_eltype);                                       \
+									      \
+scope name name##_create(size_t);                                             \
+scope name name##_create_with(size_t, const darc_allocator *alloc);           \
+scope void name##_destroy(name *);                                            \
+scope bool name##_reserve(name *, size_t);                                    \
+scope bool name##_insert(name *, size_t i, const name##_eltype *restrict src, \
+								   size_t n); \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
+scope bool name##_remove(name *, size_t i, size_t n);                         \
+scope void name##_shrink_to_fit(name *);                                      \
+scope name##_eltype *name##_at(const name *, size_t i);                       \
+scope size_t name##_spans(const name *, name##_span s[2]);                    \
+
+/* Define RGA_NOIMPL to strip implementation code */
+#ifndef RGA_NOIMPL
+
+#include <string.h>  /* memcpy(), memmove() */
+
+/* Expands function definitons for previously RGA_DECL()'d name
+ *
+ * Where "reallocfn", "freefn" are as specified for MGA_DEF().
+ */
+#define RGA_DEF(scope, name, reallocfn, freefn)                               \
+static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
+static void (*const name##_free)(void *) = freefn;                            \
+									      \
+/* Index into arr of element i, for any i < cap */                            \
+static inline size_t name##_phys_(const name *foo, size_t i)                  \
+{                                                                             \
+	return i < foo->cap-foo->head ? foo->head+i : i-(foo->cap-foo->head); \
+}                                                                             \
+									      \
+/* Moves n elements from index src to index dst, in runs that don't wrap.
+ * Both ranges must be below cap, and may overlap.
+ */                                                                           \
+static void name##_move_(name *foo, size_t dst, size_t src, size_t n)         \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	register name##_eltype *arr = foo->arr;                               \
+	register size_t cap = foo->cap;                                       \
+	if (dst < src) /* Front to back */                                    \
+		while (n) {                                                   \
+			register size_t s = name##_phys_(foo, src);           \
+			register size_t d = name##_phys_(foo, dst);           \
+			register size_t run = n;                              \
+			if (cap-s < run)                                      \
+				run = cap-s;                                  \
+			if (cap-d < run)                                      \
+				run = cap-d;                                  \
+			memmove(arr+d, arr+s, run*elsz);                      \
+			dst += run, src += run, n -= run;                     \
+		}                                                             \
+	else if (dst > src) /* Back to front */                               \
+		while (n) {                                                   \
+			register size_t s = name##_phys_(foo, src+n-1)+1;     \
+			register size_t d = name##_phys_(foo, dst+n-1)+1;     \
+			register size_t run = n;                              \
+			if (s < run)                                          \
+				run = s;                                      \
+			if (d < run)                                          \
+				run = d;                                      \
+			memmove(arr+d-run, arr+s-run, run*elsz);              \
+			n -= run;                                             \
+		}                                                             \
+}                                                                             \
+									      \
+/* Makes room for n elements at i, moving the shorter side.
+ * Elements before i keep their index, those after it gain n.
+ */                                                                           \
+static void name##_open_(name *foo, size_t i, size_t n)                       \
+{                                                                             \
+	register size_t len = foo->len;                                       \
+	if (i < len-i) {                                                      \
+		foo->head = name##_phys_(foo, foo->cap-n);                    \
+		name##_move_(foo, 0, n, i);                                   \
+	} else                                                                \
+		name##_move_(foo, i+n, i, len-i);                             \
+	foo->len = len+n;                                                     \
+}                                                                             \
+									      \
+scope name##_eltype *name##_at(const name *foo, size_t i)                     \
+{                                                                             \
+	return foo && i < foo->len ? foo->arr + name##_phys_(foo, i) : NULL;  \
+}                                                                             \
+									      \
+/* Returns the number of non-empty spans, first s[0] then s[1]. */            \
+scope size_t name##_spans(const name *foo, name##_span s[2])                  \
+{                                                                             \
+	if (foo && foo->len) {                                                \
+		register size_t run = foo->cap-foo->head;                     \
+		if (run >= foo->len) {                                        \
+			s[0] = (name##_span){foo->arr+foo->head, foo->len};   \
+			return 1;                                             \
+		}                                                             \
+		s[0] = (name##_span){foo->arr+foo->head, run};                \
+		s[1] = (name##_span){foo->arr, foo->len-run};                 \
+		return 2;                                                     \
+	} else                                                                \
+		return 0;                                                     \
+}                                                                             \
+									      \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	name res = {.alloc = alloc};                                          \
+	if (n && n <= name##_maxcap && (res.arr = darc_realloc(               \
+			alloc, name##_realloc, NULL, 0, n*elsz)) )            \
+		res.cap = n;                                                  \
+	return res;                                                           \
+}                                                                             \
+									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_with(n, NULL);                                   \
+}                                                                             \
+									      \
+/* Keeps the allocator, so foo may be reused. */                              \
+scope void name##_destroy(name *foo)                                          \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo)                                                              \
+		darc_free(foo->alloc, name##_free, foo->arr, foo->cap*elsz),  \
+		*foo = (name){.alloc = foo->alloc};                           \
+}                                                                             \
+									      \
+scope bool name##_reserve(name *foo, size_t n)                                \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo && n <= name##_maxcap) {                                      \
+		register name m = *foo;                                       \
+									      \
+		if (m.cap < n) {                                              \
+			size_t newcap = m.cap+m.cap/2; /* Try growing 1.5x */ \
+			/* Or grow to n elements if its bigger or overflow */ \
+			if (newcap < n || newcap > name##_maxcap)             \
+				newcap = n;                                   \
+									      \
+			name##_eltype *p = darc_realloc(m.alloc,              \
+				name##_realloc, m.arr, m.cap*elsz,            \
+				newcap*elsz);                                 \
+			if (!p)                                               \
+				return false;                                 \
+									      \
+			/* Unwrap by moving the shorter part of the ring,
+			 * the one wrapped to the start or the one at head.
+			 */                                                   \
+			register size_t hlen = m.cap-m.head;                  \
+			if (m.len > hlen) {                                   \
+				register size_t wlen = m.len-hlen;            \
+				if (wlen <= hlen && wlen <= newcap-m.cap)     \
+					memcpy(p+m.cap, p, wlen*elsz);        \
+				else                                          \
+					memmove(p+newcap-hlen, p+m.head,      \
+							hlen*elsz),           \
+					foo->head = newcap-hlen;              \
+			}                                                     \
+			foo->arr = p, foo->cap = newcap;                      \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* If src is NULL, elements [i, i+n) are left for caller to emplace,
+ * through name_at(), as they may wrap.
+ */                                                                           \
+scope bool name##_insert(name *dst, size_t i,                                 \
+		const name##_eltype *restrict src, size_t n)                  \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-n >= (len = dst->len) && i <= len            \
+			&& name##_reserve(dst, len+n)) {                      \
+		name##_open_(dst, i, n);                                      \
+									      \
+		/* if src is NULL, caller will emplace, don't copy */         \
+		if (src) {                                                    \
+			register size_t d = name##_phys_(dst, i);             \
+			register size_t run = dst->cap-d < n ? dst->cap-d : n;\
+			memcpy(dst->arr+d, src, run*elsz);                    \
+			memcpy(dst->arr, src+run, (n-run)*elsz);              \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* Elements [isrc, isrc+n) must exist. */                                     \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
+{                                                                             \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (foo && name##_maxcap-n >= (len = foo->len) && idst <= len         \
+		&& isrc < len && n <= len-isrc                                \
+		&& name##_reserve(foo, len+n)) {                              \
+		name##_open_(foo, idst, n);                                   \
+									      \
+		/* Source elements at or after idst have moved n ahead.
+		 * Neither part overlaps the n elements at idst.
+		 */                                                           \
+		register size_t pre = isrc < idst ? idst-isrc : 0;            \
+		if (pre > n)                                                  \
+			pre = n;                                              \
+		name##_move_(foo, idst, isrc, pre);                           \
+		name##_move_(foo, idst+pre, isrc+pre+n, n-pre);               \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_remove(name *dst, size_t i, size_t n)                       \
+{                                                                             \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-i >= n && i+n <= (len = dst->len)) {         \
+		/* Close the hole from the shorter side */                    \
+		if (i < len-i-n) {                                            \
+			name##_move_(dst, n, 0, i);                           \
+			dst->head = name##_phys_(dst, n);                     \
+		} else                                                        \
+			name##_move_(dst, i, i+n, len-i-n);                   \
+		dst->len = len-n;                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope void name##_shrink_to_fit(name *foo)                                    \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	/* Avoid reallocation if not needed, or to 0 bytes, which may free */ \
+	if (foo && !foo->len)                                                 \
+		name##_destroy(foo);                                          \
+	else if (foo && foo->cap > foo->len) {                                \
+		register name m = *foo;                                       \
+									      \
+		/* Pack elements into arr[0, len). If wrapped, leave them
+		 * wrapped, with the part at head moved to follow the rest.
+		 */                                                           \
+		register size_t hlen = m.cap-m.head;                          \
+		register size_t head = m.len > hlen ? m.len-hlen : 0;         \
+		memmove(m.arr+head, m.arr+m.head,                             \
+				(m.len > hlen ? hlen : m.len)*elsz);          \
+									      \
+		void *p = darc_realloc(m.alloc, name##_realloc,               \
+				m.arr, m.cap*elsz, m.len*elsz);               \
+		if (p)                                                        \
+			foo->arr = p, foo->cap = m.len, foo->head = head;     \
+		else /* Undo */                                               \
+			memmove(m.arr+m.head, m.arr+head,                     \
+				(m.len > hlen ? hlen : m.len)*elsz);          \
+	}                                                                     \
+}                                                                             \
+
+#define RGA_IMPL(name, reallocfn, freefn, ...)                                \
+	RGA_DECL(RGA_UNUSED static inline, name, __VA_ARGS__)                 \
+	RGA_DEF(RGA_UNUSED static inline, name, reallocfn, freefn)
+
+#endif
+#endif
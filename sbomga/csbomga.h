@@ -0,0 +1,338 @@
+#ifndef CSBOMGA_H
+#define CSBOMGA_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+
+/* Compact short-buffer-optimized arrays, like sbomga but laid out as
+ * libc++ and fbstring lay out strings : an instance is only its buffer,
+ * with the length and a flag packed in the last byte while it's short,
+ * and a pointer, length and capacity once it's on the heap.
+ *
+ * So on 64-bit targets a csbomga of chars is 24 bytes and holds up to 23
+ * inline, where an sbomga is also 24 bytes but holds 16. In exchange,
+ * - all instances of an instantiation allocate with its reallocfn/freefn,
+ *   there's no per-instance allocator, even with SBOMGA_ALLOCATOR, and
+ *   so no create_with().
+ * - the length is read with name_len(), it's not a member.
+ * - at most 127 elements are kept inline.
+ *
+ * An instance initialized with {.raw = {0}}, or static, is empty,
+ * as is one made by name_create(0).
+ */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define CSBOMGA_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define CSBOMGA_UNUSED __attribute__((unused))
+#else
+	#define CSBOMGA_UNUSED
+#endif
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+#define CSBOMGA_MAX(x,y) ( (x) > (y) ? (x) : (y) )
+#define CSBOMGA_MIN(x,y) ( (x) < (y) ? (x) : (y) )
+
+/* The last byte of an instance is its tag, which in a long instance
+ * is shared with the end of its capacity when the heap fields fill it.
+ * The capacity is stored shifted clear of the tag's flag bit, whichever
+ * end of the word that byte holds; it never needs the bit it loses.
+ */
+#if defined __BYTE_ORDER__ && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	#define CSBOMGA_LONG_ 0x01u /* Tag holds capacity's low bits */
+	#define CSBOMGA_CAPW_(cap) ((cap) << 1 | 1)
+	#define CSBOMGA_CAP_(capw) ((capw) >> 1)
+	#define CSBOMGA_TAG_(len) ((unsigned char)((len) << 1))
+	#define CSBOMGA_LEN_(tag) ((size_t)(tag) >> 1)
+#else
+	#define CSBOMGA_LONG_ 0x80u /* Tag holds capacity's high bits */
+	#define CSBOMGA_CAPW_(cap) ((cap) | ~(SIZE_MAX >> 1))
+	#define CSBOMGA_CAP_(capw) ((capw) & SIZE_MAX >> 1)
+	#define CSBOMGA_TAG_(len) ((unsigned char)(len))
+	#define CSBOMGA_LEN_(tag) ((size_t)(tag))
+#endif
+
+/* Declares an instantiation with given name, short-buffer capacity,
+ * scope and "..." element type.
+ *
+ * Where,
+ * - "scope" is empty or a valid prefix for a function declaration,
+ *   like static, inline, etc.
+ * - "name" is a valid identifier.
+ * - "sbocap" is an integer rvalue sans side effects.
+ * - "..." is a type name such that a suffixed "*" creates
+ *   a pointer to that type.
+ *
+ * Example : CSBOMGA_DECL(, str, 0, char)
+ * Declares str for chars with functions in the global scope
+ * and the default sbocap.
+ *
+ * - Member types :
+ *   - name_eltype, the type of the elements (aka value_type).
+ * - Member constants :
+ *   - name_sbocap, the actual capacity of the short-buffer.
+ *     Is at least as much as the requested capacity, up to 127.
+ *   - name_maxcap, the maxmimum number of elements.
+ *   - name_realloc, name_free; aliases of reallocfn(),freefn().
+ *
+ * - Member functions :
+ *   - name_arr()
+ *   - name_len()
+ *   - name_cap()
+ *   - name_create()
+ *   - name_destroy()
+ *   - name_reserve()
+ *   - name_insert()
+ *   - name_selfinsert()
+ *   - name_remove()
+ *   - name_shrink_to_fit()
+ */
+#define CSBOMGA_DECL(scope, name, sbocap, ...)                                \
+typedef __VA_ARGS__ name##_eltype;                                            \
+									      \
+/* Room for the heap fields, or sbocap elements and the tag */                \
+enum {                                                                        \
+	name##_objsz_ = CSBOMGA_MAX(3*sizeof(size_t), (CSBOMGA_MIN(           \
+		CSBOMGA_MAX(sbocap, 1), 127) * sizeof(name##_eltype) + 1      \
+		+ sizeof(size_t)-1) / sizeof(size_t) * sizeof(size_t)),       \
+	name##_sbocap = CSBOMGA_MIN(127,                                      \
+		(name##_objsz_-1) / sizeof(name##_eltype))                    \
+};                                                                            \
+									      \
+typedef union name {                                                          \
+	struct { name##_eltype *arr; size_t len, capw; } heap;                \
+	name##_eltype sbo[name##_sbocap];                                     \
+	unsigned char raw[name##_objsz_]; /* Tag is raw[name##_objsz_-1] */   \
+} name;                                                                       \
+									      \
+CSBOMGA_UNUSED static const size_t name##_maxcap =                            \
+	SIZE_MAX/CSBOMGA_MAX(sizeof(name##_eltype), 2); /* -1 bit -> max/2 */ \
+									      \
+scope name##_eltype *name##_arr(const name *);                                \
+scope size_t name##_len(const name *);                                        \
+scope size_t name##_cap(const name *);                                        \
+									      \
+scope name name##_create(size_t);                                             \
+scope void name##_destroy(name *);                                            \
+scope bool name##_reserve(name *, size_t);                                    \
+scope bool name##_insert(name *, size_t i,                                    \
+			const name##_eltype *restrict src, size_t n);         \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
+scope bool name##_remove(name *, size_t i, size_t n);                         \
+scope void name##_shrink_to_fit(name *);                                      \
+
+/* Define CSBOMGA_NOIMPL to strip implementation code */
+#ifndef CSBOMGA_NOIMPL
+
+#include <string.h>  /* memcpy(), memmove() */
+
+/* Expands function definitons for previously CSBOMGA_DECL()'d name */
+#define CSBOMGA_DEF(scope, name, reallocfn, freefn)                           \
+static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
+static void (*const name##_free)(void *) = freefn;                            \
+									      \
+static inline bool name##_long_(const name *foo)                              \
+{                                                                             \
+	return foo->raw[name##_objsz_-1] & CSBOMGA_LONG_;                     \
+}                                                                             \
+									      \
+/* Makes foo long, with the given heap fields */                              \
+static inline void name##_setlong_(name *foo,                                 \
+		name##_eltype *arr, size_t len, size_t cap)                   \
+{                                                                             \
+	foo->heap.arr = arr;                                                  \
+	foo->heap.len = len;                                                  \
+	foo->heap.capw = CSBOMGA_CAPW_(cap);                                  \
+	foo->raw[name##_objsz_-1] |= CSBOMGA_LONG_; /* If not in capw */      \
+}                                                                             \
+									      \
+static inline void name##_setlen_(name *foo, size_t len)                      \
+{                                                                             \
+	if (name##_long_(foo))                                                \
+		foo->heap.len = len;                                          \
+	else                                                                  \
+		foo->raw[name##_objsz_-1] = CSBOMGA_TAG_(len);                \
+}                                                                             \
+									      \
+scope name##_eltype *name##_arr(const name *foo)                              \
+{                                                                             \
+	if (!foo)                                                             \
+		return NULL;                                                  \
+	else if (name##_long_(foo))                                           \
+		return foo->heap.arr;                                         \
+	else                                                                  \
+		return (name##_eltype *)foo->sbo; /* Const cast */            \
+}                                                                             \
+									      \
+scope size_t name##_len(const name *foo)                                      \
+{                                                                             \
+	if (!foo)                                                             \
+		return 0;                                                     \
+	else if (name##_long_(foo))                                           \
+		return foo->heap.len;                                         \
+	else                                                                  \
+		return CSBOMGA_LEN_(foo->raw[name##_objsz_-1]);               \
+}                                                                             \
+									      \
+scope size_t name##_cap(const name *foo)                                      \
+{                                                                             \
+	if (!foo)                                                             \
+		return 0;                                                     \
+	else if (name##_long_(foo))                                           \
+		return CSBOMGA_CAP_(foo->heap.capw);                          \
+	else                                                                  \
+		return name##_sbocap;                                         \
+}                                                                             \
+									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	name res = {.raw = {0}};                                              \
+	if (n > name##_sbocap) { /* On failure, long with NULL arr */         \
+		void *p = n <= name##_maxcap ? name##_realloc(NULL, n*elsz)   \
+			: NULL;                                               \
+		name##_setlong_(&res, p, 0, p? n : 0);                        \
+	}                                                                     \
+	return res;                                                           \
+}                                                                             \
+									      \
+scope void name##_destroy(name *foo)                                          \
+{                                                                             \
+	if (foo) {                                                            \
+		if (name##_long_(foo))                                        \
+			name##_free(foo->heap.arr);                           \
+		foo->raw[name##_objsz_-1] = CSBOMGA_TAG_(0);                  \
+	}                                                                     \
+}                                                                             \
+									      \
+scope bool name##_reserve(name *foo, size_t n)                                \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo && n <= name##_maxcap) {                                      \
+		register bool big = name##_long_(foo);                        \
+		register size_t cap = name##_cap(foo);                        \
+									      \
+		if (cap < n) {                                                \
+			size_t newcap = cap+cap/2; /* Try growing 1.5x */     \
+			/* Or grow to n elements if its bigger or overflow */ \
+			if (newcap < n || newcap > name##_maxcap)             \
+				newcap = n;                                   \
+									      \
+			void *p = name##_realloc(big? foo->heap.arr : NULL,   \
+					newcap*elsz);                         \
+			if (p) {                                              \
+				register size_t len = name##_len(foo);        \
+				if (!big)                                     \
+					memcpy(p, foo->sbo, len*elsz);        \
+				name##_setlong_(foo, p, len, newcap);         \
+			} else                                                \
+				return false;                                 \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_insert(name *dst, size_t i,                                 \
+			 const name##_eltype *restrict src, size_t n)         \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-n >= (len = name##_len(dst)) && i <= len     \
+				     && name##_reserve(dst, len+n)) {         \
+									      \
+		register name##_eltype *arr = name##_arr(dst);                \
+									      \
+		/* move elements at i to i+n to preserve them */              \
+		memmove(arr+i+n, arr+i, (len-i)*elsz);                        \
+		/* if src == NULL, caller will emplace, don't copy */         \
+		if (src)                                                      \
+			memcpy(arr+i, src, n*elsz);                           \
+									      \
+		name##_setlen_(dst, len+n);                                   \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (foo && name##_maxcap-n >= (len = name##_len(foo)) && idst <= len  \
+		       && isrc < len && name##_reserve(foo, len+n)) {         \
+									      \
+		register name##_eltype *arr = name##_arr(foo);                \
+									      \
+		memmove(arr+idst+n, arr+idst, (len-idst)*elsz);               \
+		/* If idst < isrc, isrc has moved n ahead.
+		 * If idst == isrc, don't copy.
+		 */                                                           \
+		memmove(arr+idst, arr+isrc + (idst < isrc)*n,                 \
+					n*elsz * (idst != isrc));             \
+									      \
+		name##_setlen_(foo, len+n);                                   \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_remove(name *dst, size_t i, size_t n)                       \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-i >= n && i+n <= (len = name##_len(dst))) {  \
+									      \
+		register name##_eltype *arr = name##_arr(dst);                \
+		/* Shift elements at index > i one step back */               \
+		memmove(arr+i, arr+i+n, (len-i-n)*elsz);                      \
+									      \
+		name##_setlen_(dst, len-n);                                   \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope void name##_shrink_to_fit(name *foo)                                    \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	/* Avoid realloc() call if not needed */                              \
+	register size_t len;                                                  \
+	if (foo && name##_long_(foo)                                          \
+		&& CSBOMGA_CAP_(foo->heap.capw) > (len = foo->heap.len)) {    \
+									      \
+		if (len <= name##_sbocap) { /* Move to short buffer */        \
+			void *p = foo->heap.arr; /* Overwritten by sbo */     \
+			memcpy(foo->sbo, p, len*elsz);                        \
+			foo->raw[name##_objsz_-1] = CSBOMGA_TAG_(len);        \
+			name##_free(p);                                       \
+		} else {                                                      \
+			void *p = name##_realloc(foo->heap.arr, len*elsz);    \
+			if (p)                                                \
+				name##_setlong_(foo, p, len, len);            \
+		}                                                             \
+	}                                                                     \
+}                                                                             \
+
+#define CSBOMGA_IMPL(name, reallocfn, freefn, sbocap, ...)                    \
+CSBOMGA_DECL(CSBOMGA_UNUSED static inline, name, sbocap, __VA_ARGS__)         \
+CSBOMGA_DEF(CSBOMGA_UNUSED static inline, name, reallocfn, freefn)
+
+#endif
+#endif
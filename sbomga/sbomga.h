@@ -5,6 +5,8 @@
 #include <stddef.h>  /* size_t            */
 #include <limits.h>  /* CHAR_BIT          */
 
+#include "../alloc/allocator.h" /* darc_allocator */
+
 /* Silence unnecessary compiler warnings when static funcs/vars unused. */
 #if __STDC_VERSION__ >= 202311L
 	#define SBOMGA_UNUSED [[maybe_unused]]
@@ -21,6 +23,58 @@
 #define SBOMGA_MAX(x,y) ( (x) > (y) ? (x) : (y) )
 #define SBOMGA_NBITS(x) ( CHAR_BIT * sizeof(x)  )
 
+/* Define SBOMGA_STATS to count operations per instantiation and thread,
+ * see stats/stats.h. Otherwise, counting compiles to nothing.
+ */
+#ifdef SBOMGA_STATS
+#include <stdio.h> /* FILE */
+#include "../stats/stats.h"
+#define SBOMGA_STATS_DECL_(scope, name)                                       \
+scope darc_stats name##_stats(void);                                          \
+scope void name##_stats_reset(void);                                          \
+scope void name##_stats_dump(FILE *);
+#else
+#define SBOMGA_STATS_DECL_(scope, name)
+#endif
+
+/* Define SBOMGA_ALLOCATOR to give each instance an allocator, set by
+ * name_create_with(), at the cost of a pointer in every instance.
+ * Otherwise, instances have no alloc member and no create_with(), and all
+ * allocate with reallocfn/freefn.
+ */
+#ifdef SBOMGA_ALLOCATOR
+#define SBOMGA_ALLOC_MEMBER_ const darc_allocator *alloc;
+#define SBOMGA_ALLOC_(foo) ((foo)->alloc)
+#define SBOMGA_ALLOC_INIT_(foo, a) ((foo)->alloc = (a))
+#define SBOMGA_ALLOC_DECL_(scope, name)                                       \
+scope name name##_create_with(size_t, const darc_allocator *alloc);
+#define SBOMGA_ALLOC_DEF_(scope, name)                                        \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
+{                                                                             \
+	return name##_create_(n, alloc);                                      \
+}
+#else
+#define SBOMGA_ALLOC_MEMBER_
+#define SBOMGA_ALLOC_(foo) ((const darc_allocator *)NULL)
+#define SBOMGA_ALLOC_INIT_(foo, a) ((void)(a))
+#define SBOMGA_ALLOC_DECL_(scope, name)
+#define SBOMGA_ALLOC_DEF_(scope, name)
+#endif
+
+/* Define SBOMGA_PROFILE to report sizes per instantiation at exit,
+ * see sbomga/sbomgaprof.h. Otherwise, profiling compiles to nothing.
+ */
+#ifdef SBOMGA_PROFILE
+#include "sbomgaprof.h"
+#define SBOMGA_PROF_MEMBER_ size_t prof_peak;
+#define SBOMGA_PROF_DECL_(scope, name)                                        \
+scope void name##_profile_dump(FILE *);                                       \
+scope sbomga_prof *name##_prof_(void);
+#else
+#define SBOMGA_PROF_MEMBER_
+#define SBOMGA_PROF_DECL_(scope, name)
+#endif
+
 /* Declares an instantiation with given name, alloction functions,
  * short-buffer capacity, scope and "..." element type.
  *
@@ -41,6 +95,9 @@
  * using stdlib realloc/free for allocation/deallocation
  * and the default sbocap.
  *
+ * With SBOMGA_ALLOCATOR defined, an instance whose alloc is not NULL
+ * allocates with *alloc instead, which must outlive the instance.
+ *
  * - Member types :
  *   - name_eltype, the type of the elements (aka value_type).
  * - Member constants :
@@ -53,6 +110,8 @@
  *   - name_arr()
  *   - name_cap()
  *   - name_create()
+ *   - name_create_with(), which also sets the allocator alloc,
+ *     with SBOMGA_ALLOCATOR defined.
  *   - name_destroy()
  *   - name_reserve()
  *   - name_insert()
@@ -76,6 +135,8 @@ typedef struct name {                                                         \
 	};                                                                    \
 	size_t len : SBOMGA_NBITS(size_t)-1;                                  \
 	bool big : 1;                                                         \
+	SBOMGA_ALLOC_MEMBER_                                                  \
+	SBOMGA_PROF_MEMBER_                                                   \
 } name;                                                                       \
 									      \
 SBOMGA_UNUSED static const size_t name##_maxcap =                             \
@@ -85,6 +146,7 @@ scope name##_eltype *name##_arr(const name *);                                \
 scope size_t name##_cap(const name *foo);                                     \
 									      \
 scope name name##_create(size_t);                                             \
+SBOMGA_ALLOC_DECL_(scope, name)                                               \
 scope void name##_destroy(name *);                                            \
 scope bool name##_reserve(name *, size_t);                                    \
 scope bool name##_insert(name *, size_t i,                                    \
@@ -92,16 +154,93 @@ scope bool name##_insert(name *, size_t i,                                    \
 scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
 scope bool name##_remove(name *, size_t i, size_t n);		              \
 scope void name##_shrink_to_fit(name *);                                      \
+SBOMGA_STATS_DECL_(scope, name)                                               \
+SBOMGA_PROF_DECL_(scope, name)                                                \
 
 /* Define SBOMGA_NOIMPL to strip implementation code */
 #ifndef SBOMGA_NOIMPL
 
 #include <string.h>  /* memcpy(), memmove() */
 
+#ifdef SBOMGA_STATS
+#define SBOMGA_STATS_DEF_(scope, name)                                        \
+static DARC_TLS darc_stats name##_stats_;                                     \
+scope darc_stats name##_stats(void) { return name##_stats_; }                 \
+scope void name##_stats_reset(void) { name##_stats_ = (darc_stats){0}; }      \
+scope void name##_stats_dump(FILE *f)                                         \
+{                                                                             \
+	darc_stats_dump(f, #name, &name##_stats_);                            \
+}
+#define SBOMGA_STAT_(name, field, n) DARC_STAT_(name##_stats_, field, n)
+#define SBOMGA_PEAK_(name, sz) DARC_PEAK_(name##_stats_, sz)
+#else
+#define SBOMGA_STATS_DEF_(scope, name)
+#define SBOMGA_STAT_(name, field, n) ((void)0)
+#define SBOMGA_PEAK_(name, sz) ((void)0)
+#endif
+
+#ifdef SBOMGA_PROFILE
+#define SBOMGA_PROF_DEF_(scope, name)                                         \
+/* Defined with the functions, so that one SBOMGA_DEF() of global scope
+ * gives all translation units one profile of name, and SBOMGA_IMPL()
+ * one per translation unit.
+ */                                                                           \
+scope sbomga_prof *name##_prof_(void)                                         \
+{                                                                             \
+	static sbomga_prof prof = {                                           \
+		.id = #name, .file = __FILE__, .sbocap = name##_sbocap,       \
+		.elsz = sizeof(name##_eltype)                                 \
+	};                                                                    \
+	return &prof;                                                         \
+}                                                                             \
+static void name##_prof_atexit_(void)                                         \
+{                                                                             \
+	sbomga_prof_dump(stderr, name##_prof_());                             \
+}                                                                             \
+static sbomga_prof *name##_prof_use_(void)                                    \
+{                                                                             \
+	register sbomga_prof *p = name##_prof_();                             \
+	if (SBOMGA_PROF_ONCE_(p->registered))                                 \
+		atexit(name##_prof_atexit_);                                  \
+	return p;                                                             \
+}                                                                             \
+static void name##_prof_spill_(size_t n)                                      \
+{                                                                             \
+	register sbomga_prof *p = name##_prof_use_();                         \
+	SBOMGA_PROF_ADD_(p->spills, 1);                                       \
+	SBOMGA_PROF_ADD_(p->spill[sbomga_prof_bucket(n)], 1);                 \
+}                                                                             \
+static void name##_prof_end_(name *foo)                                       \
+{                                                                             \
+	size_t peak = sbomga_prof_bucket(foo->prof_peak);                     \
+	size_t cap = sbomga_prof_bucket(name##_cap(foo));                     \
+	register sbomga_prof *p = name##_prof_use_();                         \
+									      \
+	SBOMGA_PROF_ADD_(p->instances, 1);                                    \
+	SBOMGA_PROF_ADD_(p->peak[peak], 1);                                   \
+	SBOMGA_PROF_ADD_(p->cap[cap], 1);                                     \
+	foo->prof_peak = 0;                                                   \
+}                                                                             \
+scope void name##_profile_dump(FILE *f)                                       \
+{                                                                             \
+	sbomga_prof_dump(f, name##_prof_());                                  \
+}
+#define SBOMGA_PROF_NEED_(foo, n)                                             \
+	((void)((foo)->prof_peak < (n) ? (foo)->prof_peak = (n) : 0))
+#define SBOMGA_PROF_SPILL_(name, n) name##_prof_spill_(n)
+#define SBOMGA_PROF_END_(name, foo) name##_prof_end_(foo)
+#else
+#define SBOMGA_PROF_DEF_(scope, name)
+#define SBOMGA_PROF_NEED_(foo, n) ((void)0)
+#define SBOMGA_PROF_SPILL_(name, n) ((void)0)
+#define SBOMGA_PROF_END_(name, foo) ((void)0)
+#endif
+
 /* Expands function definitons for previously MGA_DECL()'d name */
 #define SBOMGA_DEF(scope, name, reallocfn, freefn)                            \
 static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
 static void (*const name##_free)(void *) = freefn;                            \
+SBOMGA_STATS_DEF_(scope, name)                                                \
 									      \
 scope name##_eltype *name##_arr(const name *foo)                              \
 {                                                                             \
@@ -123,22 +262,42 @@ scope size_t name##_cap(const name *foo)                                      \
 		return name##_sbocap;                                         \
 }                                                                             \
 									      \
-scope name name##_create(size_t n)                                            \
+SBOMGA_PROF_DEF_(scope, name)                                                 \
+									      \
+SBOMGA_UNUSED static inline name name##_create_(size_t n,                     \
+		const darc_allocator *alloc)                                  \
 {                                                                             \
 	enum { elsz = sizeof(name##_eltype) };                                \
 									      \
 	name res = { .big = n > name##_sbocap };                              \
-	if (res.big && n <= name##_maxcap       	                      \
-			   && (res.arr = name##_realloc(NULL, n*elsz)))       \
-		res.cap = n;                                                  \
+	SBOMGA_ALLOC_INIT_(&res, alloc);                                      \
+	SBOMGA_STAT_(name, create, 1);                                        \
+	SBOMGA_PROF_NEED_(&res, n);                                           \
+	if (res.big && n <= name##_maxcap && (res.arr = darc_realloc(         \
+			alloc, name##_realloc, NULL, 0, n*elsz)))             \
+		res.cap = n, SBOMGA_STAT_(name, reallocs, 1),                 \
+			SBOMGA_PEAK_(name, n*elsz),                           \
+			SBOMGA_PROF_SPILL_(name, n);                          \
 	return res;                                                           \
 }                                                                             \
 									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_(n, NULL);                                       \
+}                                                                             \
+SBOMGA_ALLOC_DEF_(scope, name)                                                \
+									      \
 scope void name##_destroy(name *foo)                                          \
 {                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	SBOMGA_STAT_(name, destroy, 1);                                       \
 	if (foo) {                                                            \
+		SBOMGA_PROF_END_(name, foo);                                  \
 		if (foo->big)                                                 \
-			name##_free(foo->arr), foo->big = false;              \
+			darc_free(SBOMGA_ALLOC_(foo), name##_free,            \
+					foo->arr, foo->cap*elsz),             \
+			foo->big = false;                                     \
 		foo->len = 0;                                                 \
 	}                                                                     \
 }                                                                             \
@@ -147,8 +306,10 @@ scope bool name##_reserve(name *foo, size_t n)                                \
 {                                                                             \
 	enum { elsz = sizeof(name##_eltype) };                                \
 									      \
+	SBOMGA_STAT_(name, reserve, 1);                                       \
 	if (foo && n <= name##_maxcap) {                                      \
 		register bool big = foo->big;                                 \
+		SBOMGA_PROF_NEED_(foo, n);                                    \
 		register size_t cap = big? foo->cap : name##_sbocap;          \
 									      \
 		if (cap < n) {                                                \
@@ -157,12 +318,19 @@ scope bool name##_reserve(name *foo, size_t n)                                \
 			if (newcap < n || newcap > name##_maxcap)             \
 				newcap = n;                                   \
 									      \
-			void *p = name##_realloc(big? foo->arr : NULL,        \
-					newcap*elsz);                         \
+			void *p = darc_realloc(SBOMGA_ALLOC_(foo),            \
+					name##_realloc, big? foo->arr : NULL, \
+					big? cap*elsz : 0, newcap*elsz);      \
 			if (p) {                                              \
 				if (!big)                                     \
 					memcpy(p, foo->sbo, foo->len*elsz),   \
-					foo->big = true;                      \
+					foo->big = true,                      \
+					SBOMGA_STAT_(name, spills, 1),        \
+					SBOMGA_PROF_SPILL_(name, n),          \
+					SBOMGA_STAT_(name, copied,            \
+						foo->len*elsz);               \
+				SBOMGA_STAT_(name, reallocs, 1),              \
+				SBOMGA_PEAK_(name, newcap*elsz);              \
 				foo->arr = p;                                 \
 				foo->cap = newcap;                            \
 			} else                                                \
@@ -181,6 +349,7 @@ scope bool name##_insert(name *dst, size_t i,                                 \
 	if (!n)                                                               \
 		return true;                                                  \
 									      \
+	SBOMGA_STAT_(name, insert, 1);                                        \
 	register size_t len;                                                  \
 	if (dst && name##_maxcap-n >= (len = dst->len) && i <= len            \
 				     && name##_reserve(dst, len+n)) {         \
@@ -189,9 +358,11 @@ scope bool name##_insert(name *dst, size_t i,                                 \
 									      \
 		/* move elements at i to i+n to preserve them */              \
 		memmove(arr+i+n, arr+i, (len-i)*elsz);                        \
+		SBOMGA_STAT_(name, moved, (len-i)*elsz);                      \
 		/* if src == NULL, caller will emplace, don't copy */         \
 		if (src)                                                      \
-			memcpy(arr+i, src, n*elsz);                           \
+			memcpy(arr+i, src, n*elsz),                           \
+			SBOMGA_STAT_(name, copied, n*elsz);                   \
 									      \
 		dst->len = len+n;                                             \
 		return true;                                                  \
@@ -206,6 +377,7 @@ scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
 	if (!n)                                                               \
 		return true;                                                  \
 									      \
+	SBOMGA_STAT_(name, selfinsert, 1);                                    \
 	register size_t len;                                                  \
 	if (foo && name##_maxcap-n >= (len = foo->len) && idst <= len         \
 		       && isrc < len && name##_reserve(foo, len+n)) {         \
@@ -218,6 +390,8 @@ scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
 		 */                                                           \
 		memmove(arr+idst, arr+isrc + (idst < isrc)*n,                 \
 					n*elsz * (idst != isrc));             \
+		SBOMGA_STAT_(name, moved,                                     \
+				(len-idst)*elsz + n*elsz*(idst != isrc));     \
 									      \
 		foo->len = len+n;                                             \
 		return true;                                                  \
@@ -230,11 +404,13 @@ scope bool name##_remove(name *dst, size_t i, size_t n)                       \
 	enum { elsz = sizeof(name##_eltype) };                                \
 									      \
 	register size_t len;                                                  \
+	SBOMGA_STAT_(name, remove, 1);                                        \
 	if (dst && name##_maxcap-i >= n && i+n <= (len = dst->len)) {         \
 									      \
 		register name##_eltype *arr = dst->big? dst->arr : dst->sbo;  \
 		/* Shift elements at index > i one step back */               \
 		memmove(arr+i, arr+i+n, (len-i-n)*elsz);                      \
+		SBOMGA_STAT_(name, moved, (len-i-n)*elsz);                    \
 									      \
 		dst->len = len-n;                                             \
 		return true;                                                  \
@@ -248,16 +424,23 @@ scope void name##_shrink_to_fit(name *foo)                                    \
 									      \
 	/* Avoid realloc() call if not needed */                              \
 	register size_t len;                                                  \
+	SBOMGA_STAT_(name, shrink_to_fit, 1);                                 \
 	if (foo && foo->big && foo->cap > (len = foo->len)) {                 \
 									      \
 		if (len <= name##_sbocap) { /* Move to short buffer */        \
 			void *p = foo->arr;                                   \
+			size_t sz = foo->cap*elsz;                            \
 			memcpy(foo->sbo, p, len*elsz);                        \
-			name##_free(p), foo->big = false;                     \
+			SBOMGA_STAT_(name, copied, len*elsz);                 \
+			darc_free(SBOMGA_ALLOC_(foo), name##_free, p, sz);    \
+			foo->big = false;                                     \
 		} else {                                                      \
-			void *p = name##_realloc(foo->arr, len*elsz);         \
+			void *p = darc_realloc(SBOMGA_ALLOC_(foo),            \
+					name##_realloc, foo->arr,             \
+					foo->cap*elsz, len*elsz);             \
 			if (p)                                                \
-				foo->arr = p, foo->cap = len;                 \
+				foo->arr = p, foo->cap = len,                 \
+				SBOMGA_STAT_(name, reallocs, 1);              \
 	       }                                                              \
 	}                                                                     \
 }                                                                             \
@@ -0,0 +1,143 @@
+#ifndef SBOMGAPROF_H
+#define SBOMGAPROF_H
+
+#include <limits.h> /* CHAR_BIT                    */
+#include <stddef.h> /* size_t                      */
+#include <stdio.h>  /* FILE, fprintf(), fputc()    */
+#include <stdlib.h> /* atexit()                    */
+
+/* Profiling of sbomga sizes, opted into by defining SBOMGA_PROFILE
+ * before including sbomga/sbomga.h, to pick each instantiation's sbocap.
+ *
+ * Every instance notes the largest capacity it's asked for by create(),
+ * reserve(), insert() or selfinsert(). When it's destroyed, that peak and
+ * its capacity are added to histograms of its instantiation, as is the
+ * size asked for whenever one spills from its short buffer to the heap.
+ * Only destroyed instances are counted; destroy() those that never spill
+ * as well.
+ *
+ * At exit, each instantiation that was used prints to stderr how many
+ * instances spilled, percentiles of their peaks and capacities, the sizes
+ * they spilled at, and the smallest sbocap that would have kept
+ * SBOMGA_PROFILE_TARGET percent of them in their short buffer.
+ * name_profile_dump(FILE *) prints the same at any time.
+ * Sizes of SBOMGA_PROF_EXACT or more are reported rounded up to one less
+ * than a power of 2.
+ *
+ * Instances grow by a member only present in this mode. Histograms are
+ * shared by all threads, and updated atomically with GCC or clang.
+ *
+ * Each instantiation has one profile, defined by its SBOMGA_DEF(), so one
+ * SBOMGA_DEF() of global scope serves every translation unit that
+ * SBOMGA_DECL()'s the same name. SBOMGA_IMPL()'s static functions keep
+ * one profile per translation unit instead, each reported apart under
+ * the file it was instantiated in.
+ */
+
+/* Percentage of instances a recommended sbocap keeps inline */
+#ifndef SBOMGA_PROFILE_TARGET
+#define SBOMGA_PROFILE_TARGET 90
+#endif
+
+/* Sizes below SBOMGA_PROF_EXACT have a bucket each,
+ * larger ones one per power of 2.
+ */
+enum {
+	SBOMGA_PROF_EXACT = 256, SBOMGA_PROF_EXACTBITS = 8,
+	SBOMGA_PROF_NBUCKETS = SBOMGA_PROF_EXACT + 64
+};
+
+typedef struct sbomga_prof {
+	const char *id;   /* Name of the instantiation */
+	const char *file; /* Where it's defined        */
+	size_t sbocap, elsz;
+	unsigned long long instances, spills;
+	unsigned long long peak[SBOMGA_PROF_NBUCKETS];  /* Largest asked for */
+	unsigned long long cap[SBOMGA_PROF_NBUCKETS];   /* Capacity at end   */
+	unsigned long long spill[SBOMGA_PROF_NBUCKETS]; /* Size spilled at   */
+	int registered; /* Report is due at exit */
+} sbomga_prof;
+
+#if defined __GNUC__
+	#define SBOMGA_PROF_ADD_(x, n)                                        \
+		((void)__atomic_fetch_add(&(x), (n), __ATOMIC_RELAXED))
+	#define SBOMGA_PROF_ONCE_(flag)                                       \
+		(!__atomic_exchange_n(&(flag), 1, __ATOMIC_RELAXED))
+#else
+	#define SBOMGA_PROF_ADD_(x, n) ((void)((x) += (n)))
+	#define SBOMGA_PROF_ONCE_(flag) (!(flag) ? ((flag) = 1) : 0)
+#endif
+
+static inline size_t sbomga_prof_bucket(size_t n)
+{
+	if (n < SBOMGA_PROF_EXACT)
+		return n;
+
+	register size_t log = 0;
+	while (n >>= 1)
+		log++;
+	return SBOMGA_PROF_EXACT + log - SBOMGA_PROF_EXACTBITS;
+}
+
+/* Largest size that falls in bucket b */
+static inline size_t sbomga_prof_upper(size_t b)
+{
+	if (b < SBOMGA_PROF_EXACT)
+		return b;
+
+	register unsigned log = b - SBOMGA_PROF_EXACT + SBOMGA_PROF_EXACTBITS;
+	return log+1 < sizeof(size_t)*CHAR_BIT ? ((size_t)2 << log) - 1
+		: (size_t)-1;
+}
+
+/* Smallest size that pct percent of the n counted in h are at most */
+static inline size_t sbomga_prof_pct(const unsigned long long *h,
+		unsigned long long n, unsigned pct)
+{
+	register unsigned long long sum = 0, want = (n*pct + 99)/100;
+	register size_t b = 0;
+
+	for (; b+1 < SBOMGA_PROF_NBUCKETS && (sum += h[b]) < want; b++)
+		;
+	return sbomga_prof_upper(b);
+}
+
+static inline void sbomga_prof_dump(FILE *f, const sbomga_prof *p)
+{
+	unsigned long long n = p->instances;
+
+	fprintf(f, "%s (%s): sbocap=%zu elsz=%zu instances=%llu spills=%llu\n",
+			p->id, p->file, p->sbocap, p->elsz, n, p->spills);
+	if (n) {
+		fprintf(f, "  peak: p50=%zu p90=%zu p99=%zu max=%zu\n",
+				sbomga_prof_pct(p->peak, n, 50),
+				sbomga_prof_pct(p->peak, n, 90),
+				sbomga_prof_pct(p->peak, n, 99),
+				sbomga_prof_pct(p->peak, n, 100));
+		fprintf(f, "  cap: p50=%zu p90=%zu p99=%zu max=%zu\n",
+				sbomga_prof_pct(p->cap, n, 50),
+				sbomga_prof_pct(p->cap, n, 90),
+				sbomga_prof_pct(p->cap, n, 99),
+				sbomga_prof_pct(p->cap, n, 100));
+	}
+	if (p->spills) {
+		fprintf(f, "  spilled at:");
+		for (size_t b = 0, lo = 0; b < SBOMGA_PROF_NBUCKETS; b++) {
+			size_t hi = sbomga_prof_upper(b);
+			if (p->spill[b] && lo == hi)
+				fprintf(f, " %zu:%llu", hi, p->spill[b]);
+			else if (p->spill[b])
+				fprintf(f, " %zu-%zu:%llu",
+						lo, hi, p->spill[b]);
+			lo = hi+1;
+		}
+		fputc('\n', f);
+	}
+	if (n)
+		fprintf(f, "  recommended sbocap=%zu keeps %d%% inline\n",
+				sbomga_prof_pct(p->peak, n,
+					SBOMGA_PROFILE_TARGET),
+				SBOMGA_PROFILE_TARGET);
+}
+
+#endif
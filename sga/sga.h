@@ -0,0 +1,325 @@
+#ifndef SGA_H
+#define SGA_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+#include <limits.h>  /* CHAR_BIT          */
+
+#include "../alloc/allocator.h" /* darc_allocator */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define SGA_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define SGA_UNUSED __attribute__((unused))
+#else
+	#define SGA_UNUSED
+#endif
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+/* Segment k holds SGA_BASE << k elements, from index SGA_BASE*(2^k - 1).
+ * SGA_NSEG segments are enough to index any size_t.
+ */
+enum {
+	SGA_LOG2BASE = 4,
+	SGA_BASE = 1 << SGA_LOG2BASE,
+	SGA_NSEG = CHAR_BIT*sizeof(size_t) - SGA_LOG2BASE
+};
+
+/* Returns floor(log2(x)) for x > 0 */
+static inline unsigned sga_log2_(size_t x)
+{
+#if defined __GNUC__
+	return CHAR_BIT*sizeof(unsigned long long)-1 - __builtin_clzll(x);
+#else
+	unsigned r = 0;
+	while (x >>= 1)
+		r++;
+	return r;
+#endif
+}
+
+/* Returns the segment holding index i */
+static inline unsigned sga_seg_(size_t i)
+{
+	return sga_log2_((i >> SGA_LOG2BASE) + 1);
+}
+
+/* Returns the index of the first element of segment k */
+static inline size_t sga_segstart_(unsigned k)
+{
+	return SGA_BASE * (((size_t)1 << k) - 1);
+}
+
+/* Declares a segmented array instantiation with given name,
+ * scope and "..." element type.
+ *
+ * A segmented array stores its elements in geometrically growing
+ * segments, allocated as needed and never reallocated; so growth never
+ * copies or moves elements, and pointers to them stay valid until they
+ * are removed or shifted by an insertion or removal before them.
+ * Appending is safe while other threads read elements below a len
+ * published to them with suitable synchronisation.
+ * Finding an element's segment takes O(1) time.
+ *
+ * Where,
+ * - "scope" is empty or a valid prefix for a function declaration,
+ *   like static, inline, etc.
+ * - "name" is a valid identifier.
+ * - "..." is a type name such that a suffixed "*" creates
+ *   a pointer to that type.
+ *
+ * Example : SGA_DECL(, ilog, int)
+ * Declares ilog for ints with functions in the global scope.
+ *
+ * An instance whose alloc is not NULL allocates with *alloc instead
+ * of the functions given to SGA_DEF(), and *alloc must outlive it.
+ *
+ * - Member types :
+ *   - name_eltype, the type of the elements (aka value_type).
+ * - Member constants :
+ *   - name_maxcap, the maxmimum number of elements.
+ *   - name_realloc, name_free; aliases of reallocfn(),freefn().
+ *
+ * - Member functions :
+ *   - name_create()
+ *   - name_create_with(), which also sets the allocator alloc.
+ *   - name_destroy()
+ *   - name_reserve()
+ *   - name_insert()
+ *   - name_selfinsert()
+ *   - name_remove()
+ *   - name_shrink_to_fit()
+ *   - name_at(), returns pointer to element at given index.
+ *   - name_span(), like name_at(), but also gives how many elements
+ *     from there on are contiguous.
+ */
+#define SGA_DECL(scope, name, ...)                                            \
+typedef __VA_ARGS__ name##_eltype;                                            \
+typedef struct name {                                                         \
+	size_t len, cap, nseg;                                                \
+	name##_eltype *seg[SGA_NSEG];                                         \
+	const darc_allocator *alloc;                                          \
+} name;                                                                       \
+									      \
+/* Halved, so that the size of every segment fits a size_t */                 \
+SGA_UNUSED static const size_t name##_maxcap =                                \
+	SIZE_MAX/2/sizeof(name##_eltype);                                     \
+									      \
+scope name name##_create(size_t);                                             \
+scope name name##_create_with(size_t, const darc_allocator *alloc);           \
+scope void name##_destroy(name *);                                            \
+scope bool name##_reserve(name *, size_t);                                    \
+scope bool name##_insert(name *, size_t i, const name##_eltype *restrict src, \
+								   size_t n); \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
+scope bool name##_remove(name *, size_t i, size_t n);                         \
+scope void name##_shrink_to_fit(name *);                                      \
+scope name##_eltype *name##_at(const name *, size_t i);                       \
+scope name##_eltype *name##_span(const name *, size_t i, size_t *n);          \
+
+/* Define SGA_NOIMPL to strip implementation code */
+#ifndef SGA_NOIMPL
+
+#include <string.h>  /* memcpy(), memmove() */
+
+/* Expands function definitons for previously SGA_DECL()'d name
+ *
+ * Where "reallocfn", "freefn" are as specified for MGA_DEF().
+ */
+#define SGA_DEF(scope, name, reallocfn, freefn)                               \
+static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
+static void (*const name##_free)(void *) = freefn;                            \
+									      \
+/* Pointer to element i of allocated capacity */                              \
+static inline name##_eltype *name##_loc_(const name *foo, size_t i)           \
+{                                                                             \
+	register unsigned k = sga_seg_(i);                                    \
+	return foo->seg[k] + (i - sga_segstart_(k));                          \
+}                                                                             \
+									      \
+/* Moves n elements from index src to index dst, segment by segment.
+ * Both ranges must be within capacity, and may overlap.
+ */                                                                           \
+static void name##_move_(name *foo, size_t dst, size_t src, size_t n)         \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (dst < src) /* Front to back */                                    \
+		while (n) {                                                   \
+			register size_t run = n, r;                           \
+			if ((r = sga_segstart_(sga_seg_(src)+1) - src) < run) \
+				run = r;                                      \
+			if ((r = sga_segstart_(sga_seg_(dst)+1) - dst) < run) \
+				run = r;                                      \
+			memmove(name##_loc_(foo, dst), name##_loc_(foo, src), \
+					run*elsz);                            \
+			dst += run, src += run, n -= run;                     \
+		}                                                             \
+	else if (dst > src) /* Back to front */                               \
+		while (n) {                                                   \
+			register size_t run = n, r;                           \
+			register size_t dend = dst+n, send = src+n;           \
+			if ((r = send-sga_segstart_(sga_seg_(send-1))) < run) \
+				run = r;                                      \
+			if ((r = dend-sga_segstart_(sga_seg_(dend-1))) < run) \
+				run = r;                                      \
+			memmove(name##_loc_(foo, dend-run),                   \
+				name##_loc_(foo, send-run), run*elsz);        \
+			n -= run;                                             \
+		}                                                             \
+}                                                                             \
+									      \
+scope name##_eltype *name##_at(const name *foo, size_t i)                     \
+{                                                                             \
+	return foo && i < foo->len ? name##_loc_(foo, i) : NULL;              \
+}                                                                             \
+									      \
+scope name##_eltype *name##_span(const name *foo, size_t i, size_t *n)        \
+{                                                                             \
+	if (foo && i < foo->len) {                                            \
+		register size_t end = sga_segstart_(sga_seg_(i)+1);           \
+		if (n)                                                        \
+			*n = (end < foo->len ? end : foo->len) - i;           \
+		return name##_loc_(foo, i);                                   \
+	} else                                                                \
+		return NULL;                                                  \
+}                                                                             \
+									      \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
+{                                                                             \
+	name res = {.alloc = alloc};                                          \
+	name##_reserve(&res, n);                                              \
+	return res;                                                           \
+}                                                                             \
+									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_with(n, NULL);                                   \
+}                                                                             \
+									      \
+/* Keeps the allocator, so foo may be reused. */                              \
+scope void name##_destroy(name *foo)                                          \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo) {                                                            \
+		for (size_t k = 0; k < foo->nseg; k++)                        \
+			darc_free(foo->alloc, name##_free, foo->seg[k],       \
+					((size_t)SGA_BASE << k)*elsz);        \
+		*foo = (name){.alloc = foo->alloc};                           \
+	}                                                                     \
+}                                                                             \
+									      \
+/* Allocates whole segments, never moving existing ones */                    \
+scope bool name##_reserve(name *foo, size_t n)                                \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo && n <= name##_maxcap) {                                      \
+		while (foo->cap < n) {                                        \
+			register size_t k = foo->nseg;                        \
+			void *p = darc_realloc(foo->alloc, name##_realloc,    \
+				NULL, 0, ((size_t)SGA_BASE << k)*elsz);       \
+			if (!p)                                               \
+				return false;                                 \
+			foo->seg[k] = p, foo->nseg = k+1;                     \
+			foo->cap = sga_segstart_(k+1);                        \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* If src is NULL, elements [i, i+n) are left for caller to emplace,
+ * through name_at() or name_span(), as they may span segments.
+ */                                                                           \
+scope bool name##_insert(name *dst, size_t i,                                 \
+		const name##_eltype *restrict src, size_t n)                  \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-n >= (len = dst->len) && i <= len            \
+			&& name##_reserve(dst, len+n)) {                      \
+		/* move elements at i to i+n to preserve them */              \
+		name##_move_(dst, i+n, i, len-i);                             \
+		dst->len = len+n;                                             \
+									      \
+		/* if src is NULL, caller will emplace, don't copy */         \
+		while (src && n) {                                            \
+			register size_t run = sga_segstart_(sga_seg_(i)+1)-i; \
+			if (run > n)                                          \
+				run = n;                                      \
+			memcpy(name##_loc_(dst, i), src, run*elsz);           \
+			i += run, src += run, n -= run;                       \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* Elements [isrc, isrc+n) must exist. */                                     \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
+{                                                                             \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (foo && name##_maxcap-n >= (len = foo->len) && idst <= len         \
+		&& isrc < len && n <= len-isrc                                \
+		&& name##_reserve(foo, len+n)) {                              \
+		name##_move_(foo, idst+n, idst, len-idst);                    \
+		foo->len = len+n;                                             \
+									      \
+		/* Source elements at or after idst have moved n ahead.
+		 * Neither part overlaps the n elements at idst.
+		 */                                                           \
+		register size_t pre = isrc < idst ? idst-isrc : 0;            \
+		if (pre > n)                                                  \
+			pre = n;                                              \
+		name##_move_(foo, idst, isrc, pre);                           \
+		name##_move_(foo, idst+pre, isrc+pre+n, n-pre);               \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_remove(name *dst, size_t i, size_t n)                       \
+{                                                                             \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-i >= n && i+n <= (len = dst->len)) {         \
+		/* Shift elements at index > i one step back */               \
+		name##_move_(dst, i, i+n, len-i-n);                           \
+		dst->len = len-n;                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* Frees segments holding no elements; others can't shrink, unmoved */        \
+scope void name##_shrink_to_fit(name *foo)                                    \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo)                                                              \
+		while (foo->nseg && sga_segstart_(foo->nseg-1) >= foo->len) { \
+			register size_t k = --foo->nseg;                      \
+			darc_free(foo->alloc, name##_free, foo->seg[k],       \
+					((size_t)SGA_BASE << k)*elsz);        \
+			foo->cap = sga_segstart_(k);                          \
+		}                                                             \
+}                                                                             \
+
+#define SGA_IMPL(name, reallocfn, freefn, ...)                                \
+	SGA_DECL(SGA_UNUSED static inline, name, __VA_ARGS__)                 \
+	SGA_DEF(SGA_UNUSED static inline, name, reallocfn, freefn)
+
+#endif
+#endif
@@ -0,0 +1,256 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stdbool.h> /* bool, true, false             */
+#include <stddef.h>  /* size_t                        */
+#include <stdint.h>  /* uint32_t, uint64_t            */
+#include <stdlib.h>  /* malloc(), free()              */
+#include <string.h>  /* memcpy(), memmove(), memset() */
+
+/* A stable LSD radix sort of arrays of any element size, by integer or
+ * floating point keys, shared by mga/mgasort.h and vpa/vpasort.h.
+ *
+ * RADIX_SORT_DEF_(fn, KT, keyfn, ELSZ) expands
+ *   static void fn(unsigned char *arr, unsigned char *tmp, size_t n,
+ *           size_t elsz, const void *kctx)
+ * sorting the n elements of elsz bytes at arr, using tmp, space for as
+ * many, by keys keyfn(kctx, element) : a static inline function returning
+ * KT, uint32_t or uint64_t, ordered as the keys are (see radix_key_*()).
+ * ELSZ is elsz as a constant expression, or (c->elsz) if not known,
+ * which leaves elements to be moved with calls to memcpy().
+ *
+ * Each pass sorts by one byte of the key, from the least significant;
+ * passes on bytes that are the same for all keys are skipped.
+ *
+ * Arrays of at least RADIX_PAR_MIN elements are sorted by up to
+ * RADIX_MAXTHREADS threads, each counting and scattering a chunk,
+ * unless RADIX_NOTHREADS is defined. Threads need POSIX threads.
+ */
+
+/* Elements from which sorts run on several threads */
+#ifndef RADIX_PAR_MIN
+#define RADIX_PAR_MIN ((size_t)1 << 18)
+#endif
+#ifndef RADIX_MAXTHREADS
+#define RADIX_MAXTHREADS 16
+#endif
+
+/* Elements below which insertion sort is used */
+#ifndef RADIX_SMALL
+#define RADIX_SMALL 32
+#endif
+
+#ifndef RADIX_NOTHREADS
+#include <pthread.h> /* pthread_create(), pthread_join() */
+#include <unistd.h>  /* sysconf()                        */
+#endif
+
+/* ---- Keys ----
+ *
+ * radix_key_kind(x) maps x to an unsigned radix_kt_kind,
+ * such that x < y if and only if radix_key_kind(x) < radix_key_kind(y).
+ * Negative floats sort before positive ones, -0.0 before 0.0,
+ * and NaNs after infinity or before -infinity, as per their sign.
+ */
+typedef uint32_t radix_kt_u8, radix_kt_u16, radix_kt_u32;
+typedef uint32_t radix_kt_i8, radix_kt_i16, radix_kt_i32, radix_kt_f32;
+typedef uint64_t radix_kt_u64, radix_kt_i64, radix_kt_f64;
+
+static inline uint32_t radix_key_u8(uint8_t x)   { return x; }
+static inline uint32_t radix_key_u16(uint16_t x) { return x; }
+static inline uint32_t radix_key_u32(uint32_t x) { return x; }
+static inline uint64_t radix_key_u64(uint64_t x) { return x; }
+/* Signed integers : flip the sign bit */
+static inline uint32_t radix_key_i8(int8_t x)
+{
+	return (uint8_t)x ^ 0x80u;
+}
+static inline uint32_t radix_key_i16(int16_t x)
+{
+	return (uint16_t)x ^ 0x8000u;
+}
+static inline uint32_t radix_key_i32(int32_t x)
+{
+	return (uint32_t)x ^ 0x80000000u;
+}
+static inline uint64_t radix_key_i64(int64_t x)
+{
+	return (uint64_t)x ^ 0x8000000000000000u;
+}
+/* Floats : flip all bits if negative, else only the sign bit */
+static inline uint32_t radix_key_f32(float x)
+{
+	uint32_t u;
+	memcpy(&u, &x, sizeof u);
+	return u ^ (-(u >> 31) | 0x80000000u);
+}
+static inline uint64_t radix_key_f64(double x)
+{
+	uint64_t u;
+	memcpy(&u, &x, sizeof u);
+	return u ^ (-(u >> 63) | 0x8000000000000000u);
+}
+
+/* ---- Threads ---- */
+
+/* State of one sort, shared by its threads */
+typedef struct radix_ctx_ {
+	unsigned char *src, *dst;
+	size_t n, elsz;
+	const void *kctx;
+	unsigned nt, shift;
+	size_t (*cnt)[256]; /* Per chunk counts, then offsets, of each byte */
+} radix_ctx_;
+
+/* Bounds of chunk t of nt of c's elements */
+static inline size_t radix_lo_(const radix_ctx_ *c, unsigned t)
+{
+	return c->n/c->nt*t + (t < c->n%c->nt ? t : c->n%c->nt);
+}
+
+/* Number of threads to sort n elements with */
+static inline unsigned radix_nthreads_(size_t n)
+{
+#ifndef RADIX_NOTHREADS
+	if (n >= RADIX_PAR_MIN) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		size_t nt = n / (RADIX_PAR_MIN/4); /* Keep chunks large */
+		if (cpus > 0 && (size_t)cpus < nt)
+			nt = cpus;
+		return nt < RADIX_MAXTHREADS ? (unsigned)nt : RADIX_MAXTHREADS;
+	}
+#endif
+	(void)n;
+	return 1;
+}
+
+#ifndef RADIX_NOTHREADS
+typedef struct radix_job_ {
+	void (*fn)(radix_ctx_ *, unsigned);
+	radix_ctx_ *c;
+	unsigned t;
+} radix_job_;
+
+static inline void *radix_thread_(void *p)
+{
+	radix_job_ *j = p;
+	j->fn(j->c, j->t);
+	return NULL;
+}
+#endif
+
+/* Runs fn(c, t) for each chunk t, on a thread each but the first.
+ * Chunks whose thread can't be started run on the caller's.
+ */
+static inline void radix_run_(radix_ctx_ *c,
+		void (*fn)(radix_ctx_ *, unsigned))
+{
+#ifndef RADIX_NOTHREADS
+	pthread_t th[RADIX_MAXTHREADS];
+	radix_job_ job[RADIX_MAXTHREADS];
+	bool started[RADIX_MAXTHREADS] = {false};
+
+	for (unsigned t = 1; t < c->nt; t++) {
+		job[t] = (radix_job_){fn, c, t};
+		started[t] = !pthread_create(th+t, NULL, radix_thread_, job+t);
+		if (!started[t])
+			fn(c, t);
+	}
+	fn(c, 0);
+	for (unsigned t = 1; t < c->nt; t++)
+		if (started[t])
+			pthread_join(th[t], NULL);
+#else
+	for (unsigned t = 0; t < c->nt; t++)
+		fn(c, t);
+#endif
+}
+
+/* ---- Sort ---- */
+
+#define RADIX_SORT_DEF_(fn, KT, keyfn, ELSZ)                                  \
+/* Counts the current byte of the keys of chunk t */                          \
+static void fn##_count_(radix_ctx_ *c, unsigned t)                            \
+{                                                                             \
+	register size_t elsz = ELSZ, shift = c->shift;                        \
+	register const unsigned char *p = c->src + radix_lo_(c, t)*elsz;      \
+	register const unsigned char *end = c->src + radix_lo_(c, t+1)*elsz;  \
+	register size_t *cnt = c->cnt[t];                                     \
+									      \
+	memset(cnt, 0, sizeof *c->cnt);                                       \
+	for (; p != end; p += elsz)                                           \
+		cnt[keyfn(c->kctx, p) >> shift & 255]++;                      \
+}                                                                             \
+									      \
+/* Moves chunk t to dst, at offsets by the current byte of the keys */        \
+static void fn##_scatter_(radix_ctx_ *c, unsigned t)                          \
+{                                                                             \
+	register size_t elsz = ELSZ, shift = c->shift;                        \
+	register const unsigned char *p = c->src + radix_lo_(c, t)*elsz;      \
+	register const unsigned char *end = c->src + radix_lo_(c, t+1)*elsz;  \
+	register unsigned char *dst = c->dst;                                 \
+	register size_t *off = c->cnt[t];                                     \
+									      \
+	for (; p != end; p += elsz)                                           \
+		memcpy(dst + off[keyfn(c->kctx, p) >> shift & 255]++ * elsz,  \
+				p, elsz);                                     \
+}                                                                             \
+									      \
+static void fn(unsigned char *arr, unsigned char *tmp, size_t n,              \
+		size_t elsz, const void *kctx)                                \
+{                                                                             \
+	if (n < RADIX_SMALL) { /* Insertion sort, with tmp holding one */     \
+		for (size_t i = 1; i < n; i++) {                              \
+			register KT k = keyfn(kctx, arr + i*elsz);            \
+			register size_t j = i;                                \
+			while (j && keyfn(kctx, arr + (j-1)*elsz) > k)        \
+				j--;                                          \
+			if (j < i) {                                          \
+				memcpy(tmp, arr + i*elsz, elsz);              \
+				memmove(arr + (j+1)*elsz, arr + j*elsz,       \
+						(i-j)*elsz);                  \
+				memcpy(arr + j*elsz, tmp, elsz);              \
+			}                                                     \
+		}                                                             \
+		return;                                                       \
+	}                                                                     \
+									      \
+	radix_ctx_ c = {.src = arr, .dst = tmp, .n = n, .elsz = elsz,         \
+		.kctx = kctx, .nt = radix_nthreads_(n)};                      \
+	size_t one[1][256];                                                   \
+	if (c.nt < 2 || !(c.cnt = malloc(c.nt * sizeof *c.cnt)))              \
+		c.cnt = one, c.nt = 1;                                        \
+									      \
+	for (; c.shift < 8*sizeof(KT); c.shift += 8) {                        \
+		radix_run_(&c, fn##_count_);                                  \
+									      \
+		/* Skip the byte if it's the same for all keys */             \
+		register bool same = false;                                   \
+		for (unsigned b = 0; b < 256 && !same; b++) {                 \
+			register size_t tot = 0;                              \
+			for (unsigned t = 0; t < c.nt; t++)                   \
+				tot += c.cnt[t][b];                           \
+			same = tot == n;                                      \
+		}                                                             \
+		if (same)                                                     \
+			continue;                                             \
+									      \
+		/* Offsets by byte, then by chunk, to keep it stable */       \
+		register size_t pos = 0;                                      \
+		for (unsigned b = 0; b < 256; b++)                            \
+			for (unsigned t = 0; t < c.nt; t++) {                 \
+				register size_t k = c.cnt[t][b];              \
+				c.cnt[t][b] = pos, pos += k;                  \
+			}                                                     \
+									      \
+		radix_run_(&c, fn##_scatter_);                                \
+		unsigned char *t = c.src;                                     \
+		c.src = c.dst, c.dst = t;                                     \
+	}                                                                     \
+	if (c.src != arr)                                                     \
+		memcpy(arr, c.src, n*elsz);                                   \
+	if (c.cnt != one)                                                     \
+		free(c.cnt);                                                  \
+}
+
+#endif
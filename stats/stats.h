@@ -0,0 +1,60 @@
+#ifndef DARC_STATS_H
+#define DARC_STATS_H
+
+#include <stddef.h> /* size_t              */
+#include <stdio.h>  /* FILE, fprintf()     */
+
+/* Operation counters, kept when instrumentation is opted into with
+ * MGA_STATS, SBOMGA_STATS (per instantiation), or VPA_STATS, FPA_STATS
+ * (for all vpas, fpas) defined when compiling; otherwise counting
+ * compiles to nothing and none of the stats functions exist.
+ *
+ * Counters are per thread, counting that thread's operations,
+ * and read, reset or printed with :
+ * - darc_stats name_stats(void), name_stats_reset(void),
+ *   name_stats_dump(FILE *) for an mga or sbomga name.
+ * - vpa_stats(), vpa_stats_reset(), vpa_stats_dump(FILE *),
+ *   and the same for fpa.
+ */
+typedef struct darc_stats {
+	/* Calls of each member, including those by other members,
+	 * like name_reserve() by name_insert().
+	 */
+	unsigned long long create, destroy, reserve, insert, insert_many,
+		selfinsert, remove, remove_if, remove_many, shrink_to_fit;
+
+	unsigned long long reallocs; /* Allocations and reallocations       */
+	unsigned long long moved;    /* Bytes of elements moved (memmove()) */
+	unsigned long long copied;   /* Bytes of elements copied (memcpy()) */
+	unsigned long long spills;   /* Moves from a short buffer to heap   */
+	size_t peaksz;               /* Largest capacity of one, in bytes   */
+} darc_stats;
+
+#if __STDC_VERSION__ >= 201112L && !defined __STDC_NO_THREADS__
+	#define DARC_TLS _Thread_local
+#elif defined __GNUC__
+	#define DARC_TLS __thread
+#else
+	#define DARC_TLS /* Shared by all threads */
+#endif
+
+/* Add n to counter field of darc_stats s, or note capacity of sz bytes */
+#define DARC_STAT_(s, field, n) ((void)((s).field += (n)))
+#define DARC_PEAK_(s, sz)                                                     \
+	((void)((s).peaksz < (sz) ? (s).peaksz = (sz) : 0))
+
+/* Prints s on one line, after name, as space separated key=value pairs */
+static inline void darc_stats_dump(FILE *f, const char *name,
+		const darc_stats *s)
+{
+	fprintf(f, "%s: create=%llu destroy=%llu reserve=%llu insert=%llu "
+		"insert_many=%llu selfinsert=%llu remove=%llu remove_if=%llu "
+		"remove_many=%llu shrink_to_fit=%llu reallocs=%llu "
+		"moved=%llu copied=%llu spills=%llu peaksz=%llu\n", name,
+		s->create, s->destroy, s->reserve, s->insert, s->insert_many,
+		s->selfinsert, s->remove, s->remove_if, s->remove_many,
+		s->shrink_to_fit, s->reallocs, s->moved, s->copied, s->spills,
+		(unsigned long long)s->peaksz);
+}
+
+#endif
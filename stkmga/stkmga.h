@@ -4,11 +4,35 @@
 #include <stddef.h>  /* size_t              */
 #include <string.h>  /* memcpy(), memmove() */
 #include <alloca.h>  /* alloca()            */
+#include <stdlib.h>  /* realloc(), free()   */
 
 #ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)-1)
 #endif
 
+/* Returns the bytes of stack left below the caller, or 0 if unknown,
+ * from which to pick a budget for STKMGA_CREATE_BUDGET.
+ * Only with glibc and _GNU_SOURCE defined, on a stack that grows down.
+ */
+#if defined __GLIBC__ && defined _GNU_SOURCE
+#include <pthread.h> /* pthread_getattr_np(), pthread_attr_getstack() */
+
+static inline size_t stkmga_stack_left(void)
+{
+	pthread_attr_t attr;
+	void *lo;
+	size_t sz;
+	char here;
+
+	if (pthread_getattr_np(pthread_self(), &attr))
+		return 0;
+	int err = pthread_attr_getstack(&attr, &lo, &sz);
+	pthread_attr_destroy(&attr);
+
+	return err || &here < (char *)lo ? 0 : (size_t)(&here - (char *)lo);
+}
+#endif
+
 /* Declares vector-type "vT" of elements of type "...".
  * The element type is aliased to "vT_eltype".
  * The maximum capacity is set to "vT_maxcap".
@@ -16,14 +40,20 @@
  * For example, "STKMGA_DECL(ivec, int)"
  * declares ivec as a vector of ivec_eltype (ints).
  *
+ * A vector allocates on the stack until it has used its budget,
+ * then on the heap with realloc(), and must be STKMGA_DESTROY'd
+ * (or be STKMGA_SCOPED) once it has.
+ *
  * Usable at any scope; semicolon optional.
  */
 #define STKMGA_DECL(vT, ...)                                            \
 	typedef __VA_ARGS__ vT##_eltype;                                \
 	static const size_t vT##_maxcap = SIZE_MAX/sizeof(vT##_eltype); \
 	typedef struct vT {                                             \
+		void *heap; /* arr, if it spilled to the heap */        \
 		size_t len, cap;                                        \
 		vT##_eltype *arr;                                       \
+		size_t budget; /* Bytes of stack left to alloca */      \
 	} vT;
 
 /* Initializes empty vector of vector-type "vT"
@@ -36,12 +66,49 @@
  *
  * For example, "ivec v = STKMGA_CREATE(ivec, 0);"
  * sets v's length & capacity to 0 and array to NULL.
+ * Its budget is unlimited, so it never spills to the heap.
  *
  * Is a constant expression when n is 0.
  */
-#define STKMGA_CREATE(vT, n) (vT) {                          \
-	.cap = (n),                                          \
-	.arr = (n)? alloca((n) * sizeof(vT##_eltype)) : NULL \
+#define STKMGA_CREATE(vT, n) (vT) {                           \
+	.cap = (n),                                           \
+	.arr = (n)? alloca((n) * sizeof(vT##_eltype)) : NULL, \
+	.budget = SIZE_MAX                                    \
+}
+
+/* Initializes empty vector of vector-type "vT"
+ * which allocates at most "bytes" bytes of stack,
+ * and on the heap past that.
+ *
+ * Where,
+ * "vT" is a previously declared vector-type.
+ * "bytes" is an unsigned integer rvalue.
+ *
+ * For example, "ivec v = STKMGA_CREATE_BUDGET(ivec, 4096);"
+ * keeps v on the stack while its allocations total up to 4 KiB,
+ * and "STKMGA_CREATE_BUDGET(ivec, stkmga_stack_left()/4)"
+ * up to a quarter of the stack left.
+ *
+ * Is a constant expression when bytes is.
+ */
+#define STKMGA_CREATE_BUDGET(vT, bytes) (vT) { .budget = (bytes) }
+
+/* Initializes empty vector of vector-type "vT"
+ * to capacity of n elements in buf, and on the heap past that.
+ * buf is a region of stack reserved up front, like a fixed size
+ * array or a VLA sized to a capacity hint, which holds the
+ * vector till it outgrows it; so it uses no more stack than buf,
+ * however it grows, and allocas nothing.
+ *
+ * Where,
+ * "vT", "n" are as specified for STKMGA_CREATE.
+ * "buf" is an array-of or pointer-to vT_eltype
+ * of at least n elements, that outlives the vector.
+ *
+ * For example, "int buf[256]; ivec v = STKMGA_CREATE_IN(ivec, buf, 256);"
+ */
+#define STKMGA_CREATE_IN(vT, buf, n) (vT) { \
+	.cap = (n), .arr = (buf)            \
 }
 
 /* Ensures sufficient allocation to 
@@ -55,24 +122,40 @@
  * allocates as needed such that v.arr can store
  * upto 100 ints.
  *
- * Allocation failure (stack overflow) is 
- * undetectable and is UB.
+ * Growth on the stack allocas a new block, and the old one
+ * stays till the function returns, so v uses up to about 3
+ * times its peak capacity of stack. A vector that must use
+ * no more than that is STKMGA_CREATE_IN'd a region of it.
+ *
+ * Allocation on the stack past v's budget spills to the heap,
+ * whose failure leaves v.cap < n. Allocation failure on the
+ * stack (stack overflow) is undetectable and is UB.
  */
-#define STKMGA_RESERVE(vT, v, n) do {                       \
-        enum { elsz = sizeof(vT##_eltype) };                \
-                                                            \
-        if (v.cap < (n)) {                                  \
-                size_t newcap = v.cap+v.cap/2;              \
-                if (newcap < (n) || newcap > vT##_maxcap)   \
-                        newcap = (n);                       \
-                void *new = alloca(newcap*elsz);            \
-                memcpy(new, v.arr, v.len*elsz);             \
-                v.arr = new, v.cap = newcap;                \
-        }                                                   \
+#define STKMGA_RESERVE(vT, v, n) do {                                 \
+        enum { elsz = sizeof(vT##_eltype) };                          \
+                                                                      \
+        if (v.cap < (n)) {                                            \
+                size_t newcap = v.cap+v.cap/2;                        \
+                if (newcap < (n) || newcap > vT##_maxcap)             \
+                        newcap = (n);                                 \
+                if (!v.heap && newcap*elsz <= v.budget) {             \
+                        void *new = alloca(newcap*elsz);              \
+                        memcpy(new, v.arr, v.len*elsz);               \
+                        v.arr = new, v.cap = newcap;                  \
+                        v.budget -= newcap*elsz;                      \
+                } else { /* Spill, or grow on the heap */             \
+                        void *new = realloc(v.heap, newcap*elsz);     \
+                        if (new && !v.heap)                           \
+                                memcpy(new, v.arr, v.len*elsz);       \
+                        if (new)                                      \
+                                v.heap = v.arr = new, v.cap = newcap; \
+                }                                                     \
+        }                                                             \
 } while(0)
 
 /* Inserts n vT_eltype elements from src into v at index i,
- * setting ok to 0 if out-of-bounds. Reallocates if needed.
+ * setting ok to 0 if out-of-bounds or if spilling to the heap
+ * fails. Reallocates if needed.
  * src and v.arr must not overlap.
  *
  * Where,
@@ -91,6 +174,10 @@
                                                                \
         if ((n) && vT##_maxcap-(n) >= v.len && (i) <= v.len) { \
                 STKMGA_RESERVE(vT, v, v.len+(n));              \
+                if (v.cap < v.len+(n)) {                       \
+                        ok = 0;                                \
+                        break;                                 \
+                }                                              \
                 memmove(                                       \
                         v.arr+(i)+(n), v.arr+(i),              \
                         (v.len-i)*elsz                         \
@@ -116,6 +203,10 @@
                 && (idst) <= v.len && (isrc) < v.len        \
         )  {                                                \
                 STKMGA_RESERVE(vT, v, v.len+(n));           \
+                if (v.cap < v.len+(n)) {                    \
+                        ok = 0;                             \
+                        break;                              \
+                }                                           \
                 memmove(                                    \
                         v.arr+(idst)+(n), v.arr+(idst),     \
                         (v.len-(idst))*elsz                 \
@@ -154,4 +245,30 @@
                 ok = 0;                                   \
 } while (0)
 
+/* Frees v's allocation if it spilled to the heap,
+ * and sets v's length & capacity to 0 and array to NULL.
+ * Stack allocations are only freed when the function
+ * that made them returns.
+ *
+ * Where "vT", "v" are as specified for STKMGA_RESERVE.
+ */
+#define STKMGA_DESTROY(vT, v) do { \
+        free(v.heap);              \
+        v.heap = v.arr = NULL;     \
+        v.len = v.cap = 0;         \
+} while (0)
+
+/* With GCC or clang, marks a vector variable to have its heap
+ * allocation, if any, freed when it goes out of scope.
+ *
+ * For example, "STKMGA_SCOPED ivec v = STKMGA_CREATE_BUDGET(ivec, 512);"
+ */
+#ifdef __GNUC__
+static inline void stkmga_cleanup_(void *v)
+{
+	free(*(void **)v); /* heap is the first member of every vT */
+}
+#define STKMGA_SCOPED __attribute__((cleanup(stkmga_cleanup_)))
+#endif
+
 #endif
@@ -0,0 +1,515 @@
+#ifndef TVA_H
+#define TVA_H
+
+#include <stdbool.h> /* bool, true, false */
+#include <stddef.h>  /* size_t            */
+
+#include "../alloc/allocator.h" /* darc_allocator */
+
+/* Silence unnecessary compiler warnings when static funcs/vars unused. */
+#if __STDC_VERSION__ >= 202311L
+	#define TVA_UNUSED [[maybe_unused]]
+#elif defined __GNUC__
+	#define TVA_UNUSED __attribute__((unused))
+#else
+	#define TVA_UNUSED
+#endif
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+/* log2 of the smallest block length */
+#ifndef TVA_MINLGB
+#define TVA_MINLGB 6
+#endif
+
+/* Declares a tiered vector instantiation with given name,
+ * scope and "..." element type.
+ *
+ * A tiered vector keeps its elements in blocks of B = 2^lgb elements,
+ * each a ring buffer with its own head. All blocks but the last are
+ * full, so element i is found in O(1) in block i/B at offset i%B.
+ * Inserting or removing r < B elements rotates every block after the
+ * edit by r, moving only r elements per block, and moves whole blocks
+ * by swapping pointers; so an edit anywhere costs O(B + len/B * r)
+ * instead of O(len). B is kept just above sqrt(len) by reserve() and
+ * shrink_to_fit(), which rebuild the blocks when it drifts out of
+ * (sqrt(len), 2*sqrt(len)], making single element edits O(sqrt(len)).
+ *
+ * Where,
+ * - "scope" is empty or a valid prefix for a function declaration,
+ *   like static, inline, etc.
+ * - "name" is a valid identifier.
+ * - "..." is a type name such that a suffixed "*" creates
+ *   a pointer to that type.
+ *
+ * Example : TVA_DECL(, ilist, int)
+ * Declares ilist for ints with functions in the global scope.
+ *
+ * An instance whose alloc is not NULL allocates with *alloc instead
+ * of the functions given to TVA_DEF(), and *alloc must outlive it.
+ *
+ * - Member types :
+ *   - name_eltype, the type of the elements (aka value_type).
+ *   - name_blk, a block and the index of its first element in it.
+ * - Member constants :
+ *   - name_maxcap, the maxmimum number of elements.
+ *   - name_realloc, name_free; aliases of reallocfn(),freefn().
+ *
+ * - Member functions :
+ *   - name_create()
+ *   - name_create_with(), which also sets the allocator alloc.
+ *   - name_destroy()
+ *   - name_reserve()
+ *   - name_insert()
+ *   - name_selfinsert()
+ *   - name_remove()
+ *   - name_shrink_to_fit()
+ *   - name_at(), returns pointer to element at given index.
+ *   - name_flatten(), copies all elements in order to a buffer.
+ */
+#define TVA_DECL(scope, name, ...)                                            \
+typedef __VA_ARGS__ name##_eltype;                                            \
+typedef struct name##_blk { name##_eltype *p; size_t head; } name##_blk;      \
+typedef struct name {                                                         \
+	size_t len, cap, nblk, blkcap; unsigned lgb;                          \
+	name##_blk *blk;                                                      \
+	const darc_allocator *alloc;                                          \
+} name;                                                                       \
+									      \
+TVA_UNUSED static const size_t name##_maxcap =                                \
+	SIZE_MAX/sizeof(name##_eltype);                                       \
+									      \
+scope name name##_create(size_t);                                             \
+scope name name##_create_with(size_t, const darc_allocator *alloc);           \
+scope void name##_destroy(name *);                                            \
+scope bool name##_reserve(name *, size_t);                                    \
+scope bool name##_insert(name *, size_t i, const name##_eltype *restrict src, \
+								   size_t n); \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n);  \
+scope bool name##_remove(name *, size_t i, size_t n);                         \
+scope void name##_shrink_to_fit(name *);                                      \
+scope name##_eltype *name##_at(const name *, size_t i);                       \
+scope void name##_flatten(const name *, name##_eltype *restrict dst);         \
+
+/* Define TVA_NOIMPL to strip implementation code */
+#ifndef TVA_NOIMPL
+
+#include <string.h>  /* memcpy(), memmove() */
+
+/* Expands function definitons for previously TVA_DECL()'d name
+ *
+ * Where "reallocfn", "freefn" are as specified for MGA_DEF().
+ */
+#define TVA_DEF(scope, name, reallocfn, freefn)                               \
+static void *(*const name##_realloc)(void *, size_t) = reallocfn;             \
+static void (*const name##_free)(void *) = freefn;                            \
+									      \
+/* Pointer to element i of allocated capacity. Sets *run to how many
+ * elements from there, at most n, are contiguous.
+ */                                                                           \
+static inline name##_eltype *name##_run_(const name *foo, size_t i,           \
+		size_t n, size_t *run)                                        \
+{                                                                             \
+	register size_t b = (size_t)1 << foo->lgb, mask = b-1;                \
+	register const name##_blk *k = foo->blk + (i >> foo->lgb);            \
+	register size_t j = i & mask, p = (k->head + j) & mask;               \
+									      \
+	*run = b - (j > p ? j : p);                                           \
+	if (*run > n)                                                         \
+		*run = n;                                                     \
+	return k->p + p;                                                      \
+}                                                                             \
+									      \
+/* Copies n elements from index si of s to index di of d.
+ * They may be the same instance, if the ranges don't overlap.
+ */                                                                           \
+static void name##_copy_(name *d, size_t di, const name *s, size_t si,        \
+		size_t n)                                                     \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	while (n) {                                                           \
+		size_t drun, srun;                                            \
+		name##_eltype *dp = name##_run_(d, di, n, &drun);             \
+		name##_eltype *sp = name##_run_(s, si, drun, &srun);          \
+		memcpy(dp, sp, srun*elsz);                                    \
+		di += srun, si += srun, n -= srun;                            \
+	}                                                                     \
+}                                                                             \
+									      \
+/* Moves n elements from offset sj of block ks to offset dj of block kd.
+ * Neither range may cross its block's end. If both are of one block,
+ * they may overlap.
+ */                                                                           \
+static void name##_bmove_(name *foo, size_t kd, size_t dj, size_t ks,         \
+		size_t sj, size_t n)                                          \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	register size_t b = (size_t)1 << foo->lgb, mask = b-1;                \
+	register name##_blk d = foo->blk[kd], s = foo->blk[ks];               \
+	if (kd != ks || dj < sj) /* Front to back */                          \
+		while (n) {                                                   \
+			register size_t pd = (d.head+dj) & mask;              \
+			register size_t ps = (s.head+sj) & mask;              \
+			register size_t run = b - (pd > ps ? pd : ps);        \
+			if (run > n)                                          \
+				run = n;                                      \
+			memmove(d.p+pd, s.p+ps, run*elsz);                    \
+			dj += run, sj += run, n -= run;                       \
+		}                                                             \
+	else if (dj > sj) /* Back to front */                                 \
+		while (n) {                                                   \
+			register size_t pd = ((d.head+dj+n-1) & mask) + 1;    \
+			register size_t ps = ((s.head+sj+n-1) & mask) + 1;    \
+			register size_t run = pd < ps ? pd : ps;              \
+			if (run > n)                                          \
+				run = n;                                      \
+			memmove(d.p+pd-run, s.p+ps-run, run*elsz);            \
+			n -= run;                                             \
+		}                                                             \
+}                                                                             \
+									      \
+/* Rotates the n blocks at k right by r, r <= n */                            \
+static void name##_rotate_(name##_blk *k, size_t n, size_t r)                 \
+{                                                                             \
+	/* By reversing all, then both parts */                               \
+	for (size_t lo = 0, hi = n; lo+1 < hi; lo++, hi--) {                  \
+		name##_blk t = k[lo]; k[lo] = k[hi-1], k[hi-1] = t;           \
+	}                                                                     \
+	for (size_t lo = 0, hi = r; lo+1 < hi; lo++, hi--) {                  \
+		name##_blk t = k[lo]; k[lo] = k[hi-1], k[hi-1] = t;           \
+	}                                                                     \
+	for (size_t lo = r, hi = n; lo+1 < hi; lo++, hi--) {                  \
+		name##_blk t = k[lo]; k[lo] = k[hi-1], k[hi-1] = t;           \
+	}                                                                     \
+}                                                                             \
+									      \
+/* Allocates one more block */                                                \
+static bool name##_addblk_(name *foo)                                         \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	register size_t b = (size_t)1 << foo->lgb;                            \
+	if (foo->nblk == foo->blkcap) {                                       \
+		size_t newcap = foo->blkcap+foo->blkcap/2; /* Grow 1.5x */    \
+		if (newcap <= foo->nblk)                                      \
+			newcap = foo->nblk+1;                                 \
+		name##_blk *p = darc_realloc(foo->alloc, name##_realloc,      \
+			foo->blk, foo->blkcap*sizeof *p, newcap*sizeof *p);   \
+		if (!p)                                                       \
+			return false;                                         \
+		foo->blk = p, foo->blkcap = newcap;                           \
+	}                                                                     \
+	name##_eltype *p = darc_realloc(foo->alloc, name##_realloc,           \
+			NULL, 0, b*elsz);                                     \
+	if (!p)                                                               \
+		return false;                                                 \
+	foo->blk[foo->nblk++] = (name##_blk){p, 0};                           \
+	foo->cap += b;                                                        \
+	return true;                                                          \
+}                                                                             \
+									      \
+/* Smallest lgb with n < B*B, so that B is in (sqrt(n), 2*sqrt(n)] */         \
+static unsigned name##_lgbfor_(size_t n)                                      \
+{                                                                             \
+	register unsigned lgb = TVA_MINLGB;                                   \
+	while ((n >> lgb >> lgb) >= 1)                                        \
+		lgb++;                                                        \
+	return lgb;                                                           \
+}                                                                             \
+									      \
+/* Rebuilds foo with blocks of 2^lgb elements */                              \
+static bool name##_relayout_(name *foo, unsigned lgb)                         \
+{                                                                             \
+	name m = {.lgb = lgb, .alloc = foo->alloc};                           \
+	while (m.cap < foo->len)                                              \
+		if (!name##_addblk_(&m)) {                                    \
+			name##_destroy(&m);                                   \
+			return false;                                         \
+		}                                                             \
+	name##_copy_(&m, 0, foo, 0, foo->len);                                \
+	m.len = foo->len;                                                     \
+	name##_destroy(foo);                                                  \
+	*foo = m;                                                             \
+	return true;                                                          \
+}                                                                             \
+									      \
+/* Makes room for n elements at i, with capacity for them reserved.
+ * Elements before i keep their index, those after it gain n.
+ */                                                                           \
+static void name##_open_(name *foo, size_t i, size_t n)                       \
+{                                                                             \
+	register size_t b = (size_t)1 << foo->lgb, mask = b-1;                \
+	register size_t len = foo->len;                                       \
+	foo->len = len+n;                                                     \
+	if (i == len)                                                         \
+		return;                                                       \
+									      \
+	register size_t kb = i >> foo->lgb, off = i & mask;                   \
+	register size_t r = n & mask, q = n >> foo->lgb;                      \
+	if (r) {                                                              \
+		/* Rotate every block after kb right by r, each taking
+		 * the last r elements of the one before it, from the end.
+		 * The last may spill into the next block.
+		 */                                                           \
+		register size_t last = (len-1) >> foo->lgb;                   \
+		register size_t m = len - (last << foo->lgb);                 \
+		register size_t k = m+r > b ? last+1 : last;                  \
+		if (k > last)                                                 \
+			foo->blk[k].head = 0;                                 \
+		for (; k > kb; k--) {                                         \
+			register size_t fill = k-1 == last ? m : b;           \
+			register size_t lo = b-r;                             \
+			if (k-1 == kb && off > lo)                            \
+				lo = off;                                     \
+			if (k <= last)                                        \
+				foo->blk[k].head = (foo->blk[k].head-r)&mask; \
+			if (fill > lo)                                        \
+				name##_bmove_(foo, k, lo+r-b, k-1, lo,        \
+						fill-lo);                     \
+		}                                                             \
+		/* Then shift what stays in block kb */                       \
+		register size_t fill = kb == last ? m : b;                    \
+		register size_t hi = fill < b-r ? fill : b-r;                 \
+		if (hi > off)                                                 \
+			name##_bmove_(foo, kb, off+r, kb, off, hi-off);       \
+		len += r;                                                     \
+	}                                                                     \
+	if (q) {                                                              \
+		/* Swap q free blocks in after kb, and move the elements
+		 * of kb at or after off to the last of them.
+		 */                                                           \
+		register size_t nb = ((len-1) >> foo->lgb) + 1;               \
+		name##_rotate_(foo->blk+kb+1, nb-kb-1+q, q);                  \
+		foo->blk[kb+q].head = 0;                                      \
+		register size_t fill = len - (kb << foo->lgb);                \
+		if (fill > b)                                                 \
+			fill = b;                                             \
+		if (fill > off)                                               \
+			name##_bmove_(foo, kb+q, off, kb, off, fill-off);     \
+	}                                                                     \
+}                                                                             \
+									      \
+scope name##_eltype *name##_at(const name *foo, size_t i)                     \
+{                                                                             \
+	size_t run;                                                           \
+	return foo && i < foo->len ? name##_run_(foo, i, 1, &run) : NULL;     \
+}                                                                             \
+									      \
+/* dst must have space for len elements */                                    \
+scope void name##_flatten(const name *foo, name##_eltype *restrict dst)       \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo)                                                              \
+		for (size_t i = 0, run; i < foo->len; i += run, dst += run) { \
+			name##_eltype *p = name##_run_(foo, i, foo->len-i,    \
+					&run);                                \
+			memcpy(dst, p, run*elsz);                             \
+		}                                                             \
+}                                                                             \
+									      \
+scope name name##_create_with(size_t n, const darc_allocator *alloc)          \
+{                                                                             \
+	name res = {.lgb = TVA_MINLGB, .alloc = alloc};                       \
+	name##_reserve(&res, n);                                              \
+	return res;                                                           \
+}                                                                             \
+									      \
+scope name name##_create(size_t n)                                            \
+{                                                                             \
+	return name##_create_with(n, NULL);                                   \
+}                                                                             \
+									      \
+/* Keeps the allocator, so foo may be reused. */                              \
+scope void name##_destroy(name *foo)                                          \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (foo) {                                                            \
+		register size_t b = (size_t)1 << foo->lgb;                    \
+		for (size_t k = 0; k < foo->nblk; k++)                        \
+			darc_free(foo->alloc, name##_free, foo->blk[k].p,     \
+					b*elsz);                              \
+		darc_free(foo->alloc, name##_free, foo->blk,                  \
+				foo->blkcap*sizeof *foo->blk);                \
+		*foo = (name){.lgb = TVA_MINLGB, .alloc = foo->alloc};        \
+	}                                                                     \
+}                                                                             \
+									      \
+/* Grows blocks to above sqrt(n) first, if they've fallen behind. */          \
+scope bool name##_reserve(name *foo, size_t n)                                \
+{                                                                             \
+	if (foo && n <= name##_maxcap) {                                      \
+		register unsigned lgb = name##_lgbfor_(n);                    \
+		if (lgb > foo->lgb && !name##_relayout_(foo, lgb))            \
+			return false;                                         \
+		while (foo->cap < n)                                          \
+			if (!name##_addblk_(foo))                             \
+				return false;                                 \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* If src is NULL, elements [i, i+n) are left for caller to emplace,
+ * through name_at(), as they may span blocks.
+ */                                                                           \
+scope bool name##_insert(name *dst, size_t i,                                 \
+		const name##_eltype *restrict src, size_t n)                  \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (dst && name##_maxcap-n >= (len = dst->len) && i <= len            \
+			&& name##_reserve(dst, len+n)) {                      \
+		name##_open_(dst, i, n);                                      \
+									      \
+		/* if src is NULL, caller will emplace, don't copy */         \
+		for (size_t run; src && n; i += run, src += run, n -= run) {  \
+			name##_eltype *p = name##_run_(dst, i, n, &run);      \
+			memcpy(p, src, run*elsz);                             \
+		}                                                             \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+/* Elements [isrc, isrc+n) must exist. */                                     \
+scope bool name##_selfinsert(name *foo, size_t idst, size_t isrc, size_t n)   \
+{                                                                             \
+	if (!n)                                                               \
+		return true;                                                  \
+									      \
+	register size_t len;                                                  \
+	if (foo && name##_maxcap-n >= (len = foo->len) && idst <= len         \
+		&& isrc < len && n <= len-isrc                                \
+		&& name##_reserve(foo, len+n)) {                              \
+		name##_open_(foo, idst, n);                                   \
+									      \
+		/* Source elements at or after idst have moved n ahead.
+		 * Neither part overlaps the n elements at idst.
+		 */                                                           \
+		register size_t pre = isrc < idst ? idst-isrc : 0;            \
+		if (pre > n)                                                  \
+			pre = n;                                              \
+		name##_copy_(foo, idst, foo, isrc, pre);                      \
+		name##_copy_(foo, idst+pre, foo, isrc+pre+n, n-pre);          \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+									      \
+scope bool name##_remove(name *dst, size_t i, size_t n)                       \
+{                                                                             \
+	register size_t len;                                                  \
+	if (!dst || name##_maxcap-i < n || i+n > (len = dst->len))            \
+		return false;                                                 \
+									      \
+	register size_t b = (size_t)1 << dst->lgb, mask = b-1;                \
+	register size_t kb = i >> dst->lgb, off = i & mask;                   \
+	register size_t r = n & mask, q = n >> dst->lgb;                      \
+	if (q) {                                                              \
+		/* Move the elements of block kb+q at or after off to kb,
+		 * and swap the q blocks after kb out to the end.
+		 */                                                           \
+		register size_t nb = ((len-1) >> dst->lgb) + 1;               \
+		register size_t s = (kb+q) << dst->lgb;                       \
+		register size_t fill = len > s ? len-s : 0;                   \
+		if (fill > b)                                                 \
+			fill = b;                                             \
+		if (fill > off)                                               \
+			name##_bmove_(dst, kb, off, kb+q, off, fill-off);     \
+		if (nb > kb+q)                                                \
+			name##_rotate_(dst->blk+kb+1, nb-kb-1, nb-kb-1-q);    \
+		len -= q << dst->lgb;                                         \
+	}                                                                     \
+	if (r) {                                                              \
+		/* Shift what stays in block kb, then rotate every block
+		 * after it left by r, each giving its first r elements
+		 * to the one before it.
+		 */                                                           \
+		register size_t last = (len-1) >> dst->lgb;                   \
+		register size_t m = len - (last << dst->lgb);                 \
+		register size_t fill = kb == last ? m : b;                    \
+		if (off+r < fill)                                             \
+			name##_bmove_(dst, kb, off, kb, off+r, fill-off-r);   \
+		for (size_t k = kb+1; k <= last; k++) {                       \
+			register size_t lo = 0, hi = k == last ? m : b;       \
+			if (k == kb+1 && off+r > b)                           \
+				lo = off+r-b;                                 \
+			if (hi > r)                                           \
+				hi = r;                                       \
+			if (hi > lo)                                          \
+				name##_bmove_(dst, k-1, b-r+lo, k, lo, hi-lo);\
+			dst->blk[k].head = (dst->blk[k].head+r) & mask;       \
+		}                                                             \
+		len -= r;                                                     \
+	}                                                                     \
+	dst->len = len;                                                       \
+	return true;                                                          \
+}                                                                             \
+									      \
+/* Shrinks blocks to just above sqrt(len), then frees unused ones. */         \
+scope void name##_shrink_to_fit(name *foo)                                    \
+{                                                                             \
+	enum { elsz = sizeof(name##_eltype) };                                \
+									      \
+	if (!foo)                                                             \
+		return;                                                       \
+									      \
+	register unsigned lgb = name##_lgbfor_(foo->len);                     \
+	if (lgb < foo->lgb)                                                   \
+		name##_relayout_(foo, lgb);                                   \
+									      \
+	register size_t b = (size_t)1 << foo->lgb;                            \
+	register size_t nb = (foo->len + b-1) >> foo->lgb;                    \
+	while (foo->nblk > nb)                                                \
+		darc_free(foo->alloc, name##_free, foo->blk[--foo->nblk].p,   \
+				b*elsz),                                      \
+		foo->cap -= b;                                                \
+									      \
+	/* Avoid reallocation if not needed */                                \
+	if (foo->blkcap > nb) {                                               \
+		if (!nb) {                                                    \
+			darc_free(foo->alloc, name##_free, foo->blk,          \
+					foo->blkcap*sizeof *foo->blk);        \
+			foo->blk = NULL, foo->blkcap = 0;                     \
+		} else {                                                      \
+			void *p = darc_realloc(foo->alloc, name##_realloc,    \
+				foo->blk, foo->blkcap*sizeof *foo->blk,       \
+				nb*sizeof *foo->blk);                         \
+			if (p)                                                \
+				foo->blk = p, foo->blkcap = nb;               \
+		}                                                             \
+	}                                                                     \
+}                                                                             \
+
+#define TVA_IMPL(name, reallocfn, freefn, ...)                                \
+	TVA_DECL(TVA_UNUSED static inline, name, __VA_ARGS__)                 \
+	TVA_DEF(TVA_UNUSED static inline, name, reallocfn, freefn)
+
+/* Expands a function "bool name_to_mganame(const name *, mganame *)"
+ * for previously TVA_DECL()'d name and MGA_DECL()'d mganame of the same
+ * element type, which appends all elements of the first to the second.
+ */
+#define TVA_FLATTEN_DEF(scope, name, mganame)                                 \
+scope bool name##_to_##mganame(const name *src, mganame *dst)                 \
+{                                                                             \
+	register size_t len;                                                  \
+	if (src && dst && mganame##_insert(dst, len = dst->len, NULL,         \
+				src->len)) {                                  \
+		name##_flatten(src, dst->arr+len);                            \
+		return true;                                                  \
+	} else                                                                \
+		return false;                                                 \
+}                                                                             \
+
+#endif
+#endif
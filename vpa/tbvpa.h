@@ -22,6 +22,8 @@
 #define TBVPA_GEN(name, ...)                                                 \
 typedef __VA_ARGS__ name##_eltype;                                           \
 typedef vpa name;                                                            \
+typedef vpa_ins name##_ins;                                                  \
+typedef vpa_range name##_range;                                              \
 									     \
 TBVPA_UNUSED static const size_t name##_maxcap =                             \
 	SIZE_MAX/sizeof(name##_eltype);                                      \
@@ -35,6 +37,12 @@ TBVPA_UNUSED static inline name name##_create(size_t n)                      \
 {                                                                            \
 	return vpa_create(n, sizeof(name##_eltype));                         \
 }                                                                            \
+TBVPA_UNUSED static inline name name##_create_with(                          \
+	size_t n, const darc_allocator *alloc                                \
+)                                                                            \
+{                                                                            \
+	return vpa_create_with(n, sizeof(name##_eltype), alloc);             \
+}                                                                            \
 TBVPA_UNUSED static inline void name##_destroy(name *foo)                    \
 {                                                                            \
 	vpa_destroy(foo);                                                    \
@@ -49,6 +57,12 @@ TBVPA_UNUSED static inline bool name##_insert(                               \
 {                                                                            \
 	return vpa_insert(dst, i, src, n);                                   \
 }                                                                            \
+TBVPA_UNUSED static inline bool name##_insert_many(                          \
+	name *dst, const name##_ins *ins, size_t k                           \
+)                                                                            \
+{                                                                            \
+	return vpa_insert_many(dst, ins, k);                                 \
+}                                                                            \
 TBVPA_UNUSED static inline bool name##_selfinsert(                           \
 	name *foo, size_t idst, size_t isrc, size_t n                        \
 )                                                                            \
@@ -59,6 +73,18 @@ TBVPA_UNUSED static inline bool name##_remove(name *foo, size_t i, size_t n) \
 {                                                                            \
 	return vpa_remove(foo, i, n);                                        \
 }                                                                            \
+TBVPA_UNUSED static inline size_t name##_remove_if(                          \
+	name *foo, bool (*pred)(const void *, void *), void *ctx             \
+)                                                                            \
+{                                                                            \
+	return vpa_remove_if(foo, pred, ctx);                                \
+}                                                                            \
+TBVPA_UNUSED static inline bool name##_remove_many(                          \
+	name *foo, const name##_range *r, size_t k                           \
+)                                                                            \
+{                                                                            \
+	return vpa_remove_many(foo, r, k);                                   \
+}                                                                            \
 TBVPA_UNUSED static inline void name##_shrink_to_fit(name *foo)              \
 {                                                                            \
 	vpa_shrink_to_fit(foo);                                              \
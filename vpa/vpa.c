@@ -1,10 +1,40 @@
 #include <string.h> /* memcpy(), memmove() */
 #include "vpa.h"
 
-/* Edit the below to use a custom allocator */
+/* Edit the below to use a custom allocator,
+ * or define VPA_MMAPALLOC to map large arrays with mmap()/mremap().
+ */
+#ifdef VPA_MMAPALLOC
+#include "../alloc/mmapalloc.h"
+static void *(*const vpa_realloc)(void *, size_t) = mmapalloc_realloc;
+static void  (*const vpa_free)   (void *)         = mmapalloc_free;
+#else
 #include <stdlib.h>
 static void *(*const vpa_realloc)(void *, size_t) = realloc;
 static void  (*const vpa_free)   (void *)         = free;
+#endif
+
+/* Define VPA_PMOVE to shift very large arrays with several threads */
+#ifdef VPA_PMOVE
+#include "../pmove/pmove.h"
+#define shift pmove
+#else
+#define shift memmove
+#endif
+
+/* Define VPA_STATS to count operations on all vpas, per thread */
+#ifdef VPA_STATS
+static DARC_TLS darc_stats stats;
+#define stat(field, n) DARC_STAT_(stats, field, n)
+#define peak(sz) DARC_PEAK_(stats, sz)
+
+darc_stats vpa_stats(void) { return stats; }
+void vpa_stats_reset(void) { stats = (darc_stats){0}; }
+void vpa_stats_dump(FILE *f) { darc_stats_dump(f, "vpa", &stats); }
+#else
+#define stat(field, n) ((void)0)
+#define peak(sz) ((void)0)
+#endif
 
 #ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)-1)
@@ -14,19 +44,37 @@ static inline size_t maxcap(size_t elsz) { return SIZE_MAX/elsz; }
 
 size_t vpa_maxcap(const vpa *foo) { return foo->elsz ? maxcap(foo->elsz) : 0; }
 
-vpa vpa_create(size_t n, size_t elsz)
+/* Reallocate or free v's .arr, with its allocator if it has one */
+static inline void *grow(const vpa *v, size_t newcap)
+{
+	void *p = darc_realloc(v->alloc, vpa_realloc,
+			v->arr, v->cap*v->elsz, newcap*v->elsz);
+	if (p)
+		stat(reallocs, 1), peak(newcap*v->elsz);
+	return p;
+}
+static inline void release(const vpa *v)
+{
+	darc_free(v->alloc, vpa_free, v->arr, v->cap*v->elsz);
+}
+
+vpa vpa_create_with(size_t n, size_t elsz, const darc_allocator *alloc)
 {
-	vpa res = {.elsz = elsz};
+	vpa res = {.elsz = elsz, .alloc = alloc};
+	stat(create, 1);
 	/* We use vpa_maxcap() here as it checks that elsz != 0 for us */
-	if (n && vpa_maxcap(&res) >= n && (res.arr = vpa_realloc(NULL, n*elsz)))
+	if (n && vpa_maxcap(&res) >= n && (res.arr = grow(&res, n)))
 		res.cap = n;
 	return res;
 }
 
+vpa vpa_create(size_t n, size_t elsz) { return vpa_create_with(n, elsz, NULL); }
+
 void vpa_destroy(vpa *foo)
 {
+	stat(destroy, 1);
 	if (foo) {
-		vpa_free(foo->arr), foo->arr = NULL;
+		release(foo), foo->arr = NULL;
 		foo->len = foo->cap = 0;
 	}
 }
@@ -35,6 +83,7 @@ bool vpa_reserve(vpa *foo, size_t n)
 {
 	/* Save to locals, avoid repeated indirection */
 	register size_t maxcap = vpa_maxcap(foo);
+	stat(reserve, 1);
 
 	if (foo && n <= maxcap) {
 		register vpa v = *foo;
@@ -45,7 +94,7 @@ bool vpa_reserve(vpa *foo, size_t n)
 			if (newcap < n || newcap > maxcap)
 				newcap = n;
 
-			void *p = vpa_realloc(v.arr, newcap*v.elsz);
+			void *p = grow(foo, newcap);
 			if (p)
 				foo->arr = p, foo->cap = newcap;
 			else
@@ -58,21 +107,47 @@ bool vpa_reserve(vpa *foo, size_t n)
 
 typedef unsigned char byte;
 
-bool vpa_insert(vpa *dst, size_t i, const void *restrict src, size_t n)
+/* Returns f(args..., elsz), where elsz is a constant for common sizes,
+ * so that the inlined f's multiplications are shifts and its copies of a
+ * few elements are moves of a register or two, not calls to memcpy().
+ * Elements of up to 4 cache lines are still copied with vector moves;
+ * larger ones gain little, being copied with rep movs or memcpy() anyway.
+ */
+#define by_elsz(f, elsz, ...)                                                 \
+	switch (elsz) {                                                       \
+	case 1:   return f(__VA_ARGS__, 1);                                   \
+	case 2:   return f(__VA_ARGS__, 2);                                   \
+	case 4:   return f(__VA_ARGS__, 4);                                   \
+	case 8:   return f(__VA_ARGS__, 8);                                   \
+	case 16:  return f(__VA_ARGS__, 16);                                  \
+	case 32:  return f(__VA_ARGS__, 32);                                  \
+	case 64:  return f(__VA_ARGS__, 64);                                  \
+	case 128: return f(__VA_ARGS__, 128);                                 \
+	case 256: return f(__VA_ARGS__, 256);                                 \
+	default:  return f(__VA_ARGS__, elsz);                                \
+	}
+
+static inline bool insert_(vpa *dst, size_t i, const void *restrict src,
+		size_t n, size_t elsz)
 {
-	if (n == 0)
+	register size_t len = dst->len;
+	if (i == len && n == 1 && len < dst->cap) {
+		/* Appending one element, with room for it */
+		if (src)
+			memcpy((byte *)dst->arr + len*elsz, src, elsz),
+			stat(copied, elsz);
+		dst->len = len+1;
 		return true;
-
-	register size_t len, elsz;
-	if (dst && (elsz = dst->elsz) && maxcap(elsz)-n >= (len = dst->len)
+	} else if (elsz && maxcap(elsz)-n >= len
 			&& i <= len && vpa_reserve(dst, len+n)) {
-		
+
 		byte *at_i = (byte *)dst->arr + i*elsz;
 		/* move elements at i to i+n to preserve them */
-		memmove(at_i + n*elsz, at_i, (len-i)*elsz);
+		shift(at_i + n*elsz, at_i, (len-i)*elsz);
+		stat(moved, (len-i)*elsz);
 		/* if src == NULL, caller will emplace, don't copy */
 		if(src)
-			memcpy(at_i, src, n*elsz);
+			memcpy(at_i, src, n*elsz), stat(copied, n*elsz);
 
 		dst->len = len+n;
 		return true;
@@ -80,24 +155,75 @@ bool vpa_insert(vpa *dst, size_t i, const void *restrict src, size_t n)
 		return false;
 }
 
-bool vpa_selfinsert(vpa *foo, size_t idst, size_t isrc, size_t n)
+bool vpa_insert(vpa *dst, size_t i, const void *restrict src, size_t n)
 {
 	if (n == 0)
 		return true;
-	
-	register size_t len, elsz;
-	if (foo && (elsz = foo->elsz) && maxcap(elsz)-n >= (len = foo->len)
+
+	stat(insert, 1);
+	if (!dst)
+		return false;
+
+	by_elsz(insert_, dst->elsz, dst, i, src, n)
+}
+
+bool vpa_insert_many(vpa *dst, const vpa_ins *ins, size_t k)
+{
+	register size_t len, elsz, total = 0;
+	stat(insert_many, 1);
+	if (!dst || !(elsz = dst->elsz) || (k && !ins))
+		return false;
+
+	len = dst->len;
+	for (size_t g = 0; g < k; g++)
+		if (ins[g].i > len || (g && ins[g].i < ins[g-1].i)
+				|| maxcap(elsz)-len-total < ins[g].n)
+			return false;
+		else
+			total += ins[g].n;
+
+	if (total && vpa_reserve(dst, len+total)) {
+		byte *arr = dst->arr;
+		register size_t end = len;
+
+		dst->len = len+total;
+		/* Back to front, move elements at [i, end) to their final
+		 * place, total ahead, then fill the group in before them.
+		 */
+		for (size_t g = k; g--; end = ins[g].i) {
+			byte *at_i = arr + ins[g].i*elsz;
+
+			shift(at_i + total*elsz, at_i, (end-ins[g].i)*elsz);
+			stat(moved, (end-ins[g].i)*elsz);
+			total -= ins[g].n;
+			/* if src == NULL, caller will emplace, don't copy */
+			if (ins[g].src)
+				memcpy(at_i + total*elsz, ins[g].src,
+						ins[g].n*elsz),
+				stat(copied, ins[g].n*elsz);
+		}
+		return true;
+	} else
+		return !total;
+}
+
+static inline bool selfinsert_(vpa *foo, size_t idst, size_t isrc, size_t n,
+		size_t elsz)
+{
+	register size_t len = foo->len;
+	if (elsz && maxcap(elsz)-n >= len
 		&& idst <= len && isrc < len && vpa_reserve(foo, len+n)) {
 
 		byte *at_idst = (byte *)foo->arr + idst*elsz;
 		byte *at_isrc = (byte *)foo->arr + isrc*elsz;
 
-		memmove(at_idst + n*elsz, at_idst, (len-idst)*elsz);
+		shift(at_idst + n*elsz, at_idst, (len-idst)*elsz);
 		/* If idst < isrc, isrc has moved n ahead.
 		 * If idst == isrc, don't copy.
 		 */
-		memmove(at_idst, at_isrc + (idst < isrc) * n*elsz,
+		shift(at_idst, at_isrc + (idst < isrc) * n*elsz,
 				n*elsz * (idst != isrc));
+		stat(moved, (len-idst)*elsz + n*elsz * (idst != isrc));
 
 		foo->len = len+n;
 		return true;
@@ -105,28 +231,103 @@ bool vpa_selfinsert(vpa *foo, size_t idst, size_t isrc, size_t n)
 		return false;
 }
 
-bool vpa_remove(vpa *dst, size_t i, size_t n)
+bool vpa_selfinsert(vpa *foo, size_t idst, size_t isrc, size_t n)
 {
-	register vpa v;
-	if (dst && (v = *dst).elsz
-			&& maxcap(v.elsz)-i >= n && i+n <= v.len) {
+	if (n == 0)
+		return true;
+
+	stat(selfinsert, 1);
+	if (!foo)
+		return false;
+
+	by_elsz(selfinsert_, foo->elsz, foo, idst, isrc, n)
+}
 
-		byte *at_i = (byte *)v.arr + i*v.elsz;
+static inline bool remove_(vpa *dst, size_t i, size_t n, size_t elsz)
+{
+	register size_t len = dst->len;
+	if (elsz && maxcap(elsz)-i >= n && i+n <= len) {
+		byte *at_i = (byte *)dst->arr + i*elsz;
 		/* Shift elements at index > i one step back */
-		memmove(at_i, at_i + n*v.elsz, (v.len-i-n)*v.elsz);
+		shift(at_i, at_i + n*elsz, (len-i-n)*elsz);
+		stat(moved, (len-i-n)*elsz);
 
-		dst->len = v.len-n;
+		dst->len = len-n;
 		return true;
 	} else
 		return false;
 }
 
+bool vpa_remove(vpa *dst, size_t i, size_t n)
+{
+	stat(remove, 1);
+	if (!dst)
+		return false;
+
+	by_elsz(remove_, dst->elsz, dst, i, n)
+}
+
+size_t vpa_remove_if(vpa *foo, bool (*pred)(const void *, void *), void *ctx)
+{
+	register vpa v;
+	stat(remove_if, 1);
+	if (!foo || !(v = *foo).elsz)
+		return 0;
+
+	byte *arr = v.arr;
+	register size_t r = 0, w;
+
+	/* Elements before the first removed one stay put */
+	while (r < v.len && !pred(arr + r*v.elsz, ctx))
+		r++;
+	for (w = r; r < v.len; ) {
+		while (r < v.len && pred(arr + r*v.elsz, ctx))
+			r++;
+		register size_t run = r;
+		while (r < v.len && !pred(arr + r*v.elsz, ctx))
+			r++;
+		/* Move the kept run straight to its final place */
+		shift(arr + w*v.elsz, arr + run*v.elsz, (r-run)*v.elsz);
+		stat(moved, (r-run)*v.elsz);
+		w += r-run;
+	}
+	foo->len = w;
+	return v.len-w;
+}
+
+bool vpa_remove_many(vpa *dst, const vpa_range *r, size_t k)
+{
+	register vpa v;
+	stat(remove_many, 1);
+	if (!dst || !(v = *dst).elsz || (k && !r))
+		return false;
+
+	for (size_t g = 0; g < k; g++)
+		if (maxcap(v.elsz)-r[g].i < r[g].n || r[g].i+r[g].n > v.len
+			|| (g && r[g].i < r[g-1].i+r[g-1].n))
+			return false;
+
+	byte *arr = v.arr;
+	register size_t w = k? r[0].i : v.len;
+	for (size_t g = 0; g < k; g++) {
+		/* Shift elements between this range and the next back */
+		register size_t from = r[g].i+r[g].n;
+		register size_t to = g+1 < k ? r[g+1].i : v.len;
+		shift(arr + w*v.elsz, arr + from*v.elsz, (to-from)*v.elsz);
+		stat(moved, (to-from)*v.elsz);
+		w += to-from;
+	}
+	dst->len = w;
+	return true;
+}
+
 void vpa_shrink_to_fit(vpa *foo)
 {
 	/* Avoid realloc() call if not needed */
 	register vpa v;
+	stat(shrink_to_fit, 1);
 	if(foo && (v = *foo).elsz && v.cap > v.len) {
-		void *p = vpa_realloc(v.arr, v.len*v.elsz);
+		void *p = grow(foo, v.len);
 		if (p)
 			foo->arr = p, foo->cap = v.len;
 	}
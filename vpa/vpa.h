@@ -4,12 +4,18 @@
 #include <stdbool.h> /* bool   */
 #include <stddef.h>  /* size_t */
 
+#include "../alloc/allocator.h" /* darc_allocator */
+
 /* arr is a buffer of len elems allocated for upto cap elems,
  * where each elem is elsz bytes in size.
+ *
+ * arr is allocated with *alloc, or vpa.c's realloc/free if alloc is NULL.
+ * *alloc must outlive the vpa.
  */
 typedef struct vpa {
         size_t len, cap, elsz;
         void *arr;
+        const darc_allocator *alloc;
 } vpa;
 
 /* Returns the largest possible capacity of the vpa. 
@@ -22,7 +28,10 @@ size_t vpa_maxcap(const vpa *v);
  */
 vpa vpa_create(size_t n, size_t elsz);
 
-/* free()'s .arr & resets all feilds to 0 */
+/* Like vpa_create(), but allocating with alloc */
+vpa vpa_create_with(size_t n, size_t elsz, const darc_allocator *alloc);
+
+/* free()'s .arr & resets all feilds but .elsz and .alloc to 0 */
 void vpa_destroy(vpa *);
 
 /* Ensures capacity of at least n elems in .arr
@@ -39,6 +48,22 @@ bool vpa_reserve(vpa *, size_t n);
  */
 bool vpa_insert(vpa *, size_t i, const void *restrict src, size_t n);
 
+/* Describes n elements from src to insert before .arr[i] */
+typedef struct vpa_ins {
+	size_t i;
+	const void *src;
+	size_t n;
+} vpa_ins;
+
+/* Inserts k groups of elements, each as if by vpa_insert(),
+ * where .i indexes .arr as it was before the call.
+ * Groups must be sorted by .i; groups with equal .i are inserted in order.
+ * Reserves at most once and moves each element at most once.
+ *
+ * Returns true if successful, else false.
+ */
+bool vpa_insert_many(vpa *, const vpa_ins *ins, size_t k);
+
 /* Inserts n elements from .arr[isrc] at .arr[idst].
  * Returns true if successful, else false.
  */
@@ -49,9 +74,40 @@ bool vpa_selfinsert(vpa *, size_t idst, size_t isrc, size_t n);
  */
 bool vpa_remove(vpa *, size_t i, size_t n);
 
+/* Removes elements for which pred(element, ctx) is true,
+ * in a single pass that keeps the order of the rest.
+ * Returns how many were removed.
+ */
+size_t vpa_remove_if(vpa *, bool (*pred)(const void *el, void *ctx), void *ctx);
+
+/* Describes n elements from .arr[i] onwards */
+typedef struct vpa_range {
+	size_t i, n;
+} vpa_range;
+
+/* Removes k ranges of elements in a single pass,
+ * where .i indexes .arr as it was before the call.
+ * Ranges must be sorted by .i and not overlap.
+ *
+ * Returns true on success or false on failure (out-of-bounds, unsorted).
+ */
+bool vpa_remove_many(vpa *, const vpa_range *r, size_t k);
+
 /* Dynamic arrays overallocate for efficiency,
  * Reallocs .arr (if not already) to .cap == .len
  */
 void vpa_shrink_to_fit(vpa *);
 
+/* Compile vpa.c with VPA_STATS to count this thread's operations on vpas,
+ * see stats/stats.h.
+ */
+#ifdef VPA_STATS
+#include <stdio.h> /* FILE */
+#include "../stats/stats.h"
+
+darc_stats vpa_stats(void);
+void vpa_stats_reset(void);
+void vpa_stats_dump(FILE *);
+#endif
+
 #endif
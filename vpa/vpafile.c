@@ -0,0 +1,179 @@
+#if defined __linux__ && !defined _GNU_SOURCE
+#define _GNU_SOURCE /* mremap(), MREMAP_MAYMOVE */
+#endif
+
+#include <stdint.h>   /* uint64_t                            */
+#include <stdlib.h>   /* malloc(), free()                    */
+#include <string.h>   /* memcmp(), memcpy()                  */
+#include <errno.h>    /* errno, EINVAL, EFBIG                */
+#include <fcntl.h>    /* open(), O_RDWR, O_CREAT             */
+#include <unistd.h>   /* close(), ftruncate()                */
+#include <sys/stat.h> /* fstat()                             */
+#include <sys/mman.h> /* mmap(), munmap(), mremap(), msync() */
+#include "vpafile.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)-1)
+#endif
+
+/* Header at the start of the file. Elements follow at HDRSZ,
+ * which keeps them as aligned as the (page aligned) mapping needs.
+ */
+typedef struct hdr {
+	char magic[8];
+	uint64_t order; /* ORDER as written, to detect byte order */
+	uint64_t elsz, len;
+} hdr;
+enum { HDRSZ = 64 };
+static const char MAGIC[8] = "darcvpa";
+static const uint64_t ORDER = 0x0102030405060708;
+
+struct vpafile {
+	int fd;
+	unsigned char *base; /* Mapping of the whole file */
+	size_t mapsz;
+	bool taken; /* The block is the vpa's, until it frees it */
+	darc_allocator alloc;
+};
+
+static unsigned char *map(int fd, size_t mapsz)
+{
+	void *p = mmap(NULL, mapsz, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	return p == MAP_FAILED ? NULL : p;
+}
+
+/* Resizes f's file and mapping to mapsz bytes, preserving contents.
+ * Truncates after unmapping when shrinking, so no mapped page is cut off.
+ */
+static bool resize(vpafile *f, size_t mapsz)
+{
+	size_t oldsz = f->mapsz;
+	if (mapsz > oldsz && ftruncate(f->fd, (off_t)mapsz))
+		return false;
+
+	#ifdef __linux__
+	void *p = mremap(f->base, f->mapsz, mapsz, MREMAP_MAYMOVE);
+	if (p == MAP_FAILED)
+		p = NULL;
+	#else
+	/* Both map the same file, so no copying is needed */
+	void *p = map(f->fd, mapsz);
+	if (p)
+		munmap(f->base, f->mapsz);
+	#endif
+	/* A failed ftruncate() below only leaves the file longer than needed */
+	if (!p) {
+		if (mapsz > oldsz && ftruncate(f->fd, (off_t)oldsz)) {}
+		return false;
+	}
+	f->base = p, f->mapsz = mapsz;
+
+	if (mapsz < oldsz && ftruncate(f->fd, (off_t)mapsz)) {}
+	return true;
+}
+
+/* The file's allocator, for its one block, the elements after the header.
+ * Any other block, like a new one while that is taken, can't be allocated,
+ * and is not freed.
+ */
+static void *file_realloc(void *ctx, void *p, size_t oldsz, size_t newsz)
+{
+	vpafile *f = ctx;
+	(void)oldsz;
+	if (p ? p != f->base+HDRSZ : f->taken)
+		return NULL;
+	else if (newsz <= SIZE_MAX-HDRSZ && resize(f, HDRSZ+newsz)) {
+		f->taken = true;
+		return f->base+HDRSZ;
+	} else
+		return NULL;
+}
+static void file_free(void *ctx, void *p, size_t sz)
+{
+	vpafile *f = ctx;
+	(void)sz;
+	if (p == f->base+HDRSZ) {
+		((hdr *)f->base)->len = 0;
+		resize(f, HDRSZ);
+		f->taken = false;
+	}
+}
+
+vpafile *vpafile_open(const char *path, size_t elsz, vpa *v)
+{
+	if (!elsz) {
+		errno = EINVAL;
+		return NULL;
+	}
+	vpafile *f = malloc(sizeof *f);
+	if (!f)
+		return NULL;
+	*f = (vpafile){.fd = -1, .taken = true};
+	f->alloc = (darc_allocator){file_realloc, file_free, f};
+
+	struct stat st;
+	if ((f->fd = open(path, O_RDWR|O_CREAT, 0666)) < 0
+			|| fstat(f->fd, &st))
+		goto fail;
+
+	hdr *h;
+	if (st.st_size == 0) { /* New file */
+		if (ftruncate(f->fd, HDRSZ) || !(f->base = map(f->fd, HDRSZ)))
+			goto fail;
+		f->mapsz = HDRSZ;
+		h = (hdr *)f->base;
+		memcpy(h->magic, MAGIC, sizeof MAGIC);
+		h->order = ORDER, h->elsz = elsz, h->len = 0;
+	} else {
+		if (st.st_size < HDRSZ || (uintmax_t)st.st_size > SIZE_MAX) {
+			errno = st.st_size < HDRSZ ? EINVAL : EFBIG;
+			goto fail;
+		}
+		if (!(f->base = map(f->fd, st.st_size)))
+			goto fail;
+		f->mapsz = st.st_size;
+		h = (hdr *)f->base;
+		if (memcmp(h->magic, MAGIC, sizeof MAGIC) || h->order != ORDER
+				|| h->elsz != elsz
+				|| h->len > (f->mapsz-HDRSZ)/elsz) {
+			errno = EINVAL;
+			goto fail;
+		}
+	}
+	*v = (vpa){
+		.len = h->len, .cap = (f->mapsz-HDRSZ)/elsz, .elsz = elsz,
+		.arr = f->base+HDRSZ, .alloc = &f->alloc
+	};
+	return f;
+
+fail: ; /* Clean up, keeping errno of the first failure */
+	int e = errno;
+	if (f->base)
+		munmap(f->base, f->mapsz);
+	if (f->fd >= 0)
+		close(f->fd);
+	free(f);
+	errno = e;
+	return NULL;
+}
+
+bool vpafile_sync(vpafile *f, const vpa *v)
+{
+	((hdr *)f->base)->len = v->len;
+	return !msync(f->base, f->mapsz, MS_SYNC);
+}
+
+bool vpafile_close(vpafile *f, vpa *v)
+{
+	bool ok = vpafile_sync(f, v);
+	int e = errno;
+
+	munmap(f->base, f->mapsz);
+	if (close(f->fd) && ok)
+		ok = false, e = errno;
+	free(f);
+	*v = (vpa){.elsz = v->elsz};
+
+	errno = e;
+	return ok;
+}
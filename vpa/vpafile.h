@@ -0,0 +1,64 @@
+#ifndef VPAFILE_H
+#define VPAFILE_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h>  /* size_t */
+
+#include "vpa.h"
+
+/* A vpa whose storage is a memory-mapped file, so that an array
+ * persisted by one process is ready for use by the next after one mmap(),
+ * without parsing or copying.
+ *
+ * The file holds a small header (recording elsz and len) followed by cap
+ * elements. The vpa is given an allocator that grows the file with
+ * ftruncate() and remaps it, so vpa_reserve(), vpa_insert() etc. work as
+ * usual; and as with realloc(), growth may move .arr.
+ * That allocator serves only the one array : it can't allocate another
+ * block, say for scratch space, while the array holds the file's, so give
+ * other vpas their own allocator.
+ * The file is native-endian and not portable across architectures;
+ * opening a file of another byte order or element size fails.
+ *
+ * Changes reach the file as the kernel writes pages back; len in the
+ * header is only updated by vpafile_sync() and vpafile_close(), which are
+ * the durability points. After a crash, elements up to the last synced
+ * len are intact if they were not modified since.
+ *
+ * e.g.
+ *   vpa v;
+ *   vpafile *f = vpafile_open("points.vpa", sizeof(struct point), &v);
+ *   if (!f)
+ *       err(1, "points.vpa");
+ *   vpa_insert(&v, v.len, &p, 1);
+ *   vpafile_close(f, &v);
+ *
+ * A vpafile is for one vpa, and not thread-safe.
+ */
+typedef struct vpafile vpafile;
+
+/* Opens or creates the file at path, and sets *v to the array in it,
+ * of elements elsz bytes each, with the file's allocator.
+ *
+ * Returns NULL and sets errno on failure, as when the file is not a vpa
+ * file (EINVAL) or is of another element size (EINVAL).
+ */
+vpafile *vpafile_open(const char *path, size_t elsz, vpa *v);
+
+/* Records v->len in the header, then flushes the mapping to the file
+ * with msync(), returning when it is written.
+ *
+ * Returns true if successful, else false and sets errno.
+ */
+bool vpafile_sync(vpafile *f, const vpa *v);
+
+/* Syncs v, unmaps and closes the file, frees f and resets *v.
+ * Unlike vpa_destroy(), which discards the elements in the file,
+ * this keeps them for the next vpafile_open().
+ *
+ * Returns true if successful, else false and sets errno;
+ * f is freed either way.
+ */
+bool vpafile_close(vpafile *f, vpa *v);
+
+#endif
@@ -0,0 +1,105 @@
+#include <errno.h>   /* errno, EINTR, EINVAL, EIO, ENOMEM */
+#include <limits.h>  /* SSIZE_MAX, IOV_MAX                */
+#include <unistd.h>  /* read(), ssize_t                   */
+#include <sys/uio.h> /* writev(), struct iovec            */
+#include "vpaio.h"
+
+#ifndef SSIZE_MAX
+#define SSIZE_MAX ((size_t)-1 / 2)
+#endif
+#ifndef IOV_MAX
+#define IOV_MAX 16 /* The least POSIX allows */
+#endif
+
+typedef unsigned char byte;
+
+enum { IOVBATCH = IOV_MAX < 64 ? IOV_MAX : 64 }; /* iovecs per writev() */
+
+/* Writes the cnt buffers of iov in full, adjusting them as it goes */
+static bool writeiov(int fd, struct iovec *iov, int cnt)
+{
+	while (cnt) {
+		ssize_t w = writev(fd, iov, cnt);
+		if (w < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		/* Skip what was written, resume partway through a buffer */
+		for (; cnt && (size_t)w >= iov->iov_len; iov++, cnt--)
+			w -= iov->iov_len;
+		if (cnt)
+			iov->iov_base = (byte *)iov->iov_base + w,
+			iov->iov_len -= w;
+	}
+	return true;
+}
+
+size_t vpa_read(vpa *foo, int fd, size_t n)
+{
+	if (!n)
+		return 0;
+	if (!foo || foo->len+n < n || !vpa_reserve(foo, foo->len+n)) {
+		errno = ENOMEM;
+		return 0;
+	}
+	register size_t elsz = foo->elsz;
+	register byte *dst = (byte *)foo->arr + foo->len*elsz;
+	register size_t want = n*elsz, got = 0;
+
+	errno = 0;
+	while (got < want) {
+		ssize_t r = read(fd, dst+got,
+				want-got > SSIZE_MAX ? SSIZE_MAX : want-got);
+		if (r > 0)
+			got += r;
+		else if (r < 0 && errno == EINTR)
+			errno = 0;
+		else /* End of file, or error */
+			break;
+	}
+	if (got % elsz && !errno)
+		errno = EIO;
+
+	foo->len += got/elsz;
+	return got/elsz;
+}
+
+bool vpa_write(const vpa *foo, int fd, size_t i, size_t n)
+{
+	vpa_range r = {i, n};
+	return vpa_writev(foo, fd, &r, 1);
+}
+
+bool vpa_writev(const vpa *foo, int fd, const vpa_range *r, size_t k)
+{
+	if (!foo) {
+		errno = EINVAL;
+		return false;
+	}
+	register size_t elsz = foo->elsz, len = foo->len;
+	struct iovec iov[IOVBATCH];
+	int cnt = 0;
+
+	for (size_t g = 0; g < k; g++) {
+		if (r[g].i > len || r[g].n > len-r[g].i) {
+			errno = EINVAL;
+			return false;
+		}
+		/* Split ranges too large for one writev() */
+		register byte *p = (byte *)foo->arr + r[g].i*elsz;
+		register size_t sz = r[g].n*elsz;
+		while (sz) {
+			register size_t run = sz > SSIZE_MAX/IOVBATCH ?
+				SSIZE_MAX/IOVBATCH : sz;
+			iov[cnt++] = (struct iovec){p, run};
+			p += run, sz -= run;
+			if (cnt == IOVBATCH) {
+				if (!writeiov(fd, iov, cnt))
+					return false;
+				cnt = 0;
+			}
+		}
+	}
+	return writeiov(fd, iov, cnt);
+}
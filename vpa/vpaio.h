@@ -0,0 +1,35 @@
+#ifndef VPAIO_H
+#define VPAIO_H
+
+#include <stdbool.h> /* bool   */
+#include <stddef.h>  /* size_t */
+
+#include "vpa.h"
+
+/* POSIX file descriptor I/O straight to and from a vpa's .arr,
+ * without a scratch buffer. All retry on EINTR and on partial transfers.
+ */
+
+/* Reserves n more elements, then reads into them at .arr[.len] until
+ * n elements are read, end of file, or an error (including EAGAIN),
+ * and grows .len by the number of whole elements read.
+ *
+ * Returns that number. If less than n, errno is 0 at end of file, or
+ * else that of the error; or ENOMEM if it could not reserve.
+ * The bytes of an element cut short are discarded, and errno is EIO
+ * if that was due to end of file.
+ */
+size_t vpa_read(vpa *, int fd, size_t n);
+
+/* Writes n elements from .arr[i] onwards to fd.
+ * Returns true if all were written, else false and sets errno.
+ */
+bool vpa_write(const vpa *, int fd, size_t i, size_t n);
+
+/* Writes k ranges of elements to fd in order, gathered with writev().
+ * Returns true if all were written, else false and sets errno,
+ * to EINVAL if a range is out of bounds.
+ */
+bool vpa_writev(const vpa *, int fd, const vpa_range *r, size_t k);
+
+#endif
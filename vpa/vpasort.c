@@ -0,0 +1,92 @@
+#include <stdint.h>  /* uint8_t, uint16_t, uint32_t, uint64_t */
+#include <string.h>  /* memcpy()                               */
+#include "vpasort.h"
+#include "../sort/radix.h"
+
+typedef unsigned char byte;
+
+/* Where and how to read keys */
+typedef struct key {
+	size_t off;
+	uint64_t flip; /* Sign bit of signed integers, else 0 */
+	bool isfloat;
+} key;
+
+static inline uint32_t key1(const void *ctx, const byte *p)
+{
+	register const key *k = ctx;
+	return p[k->off] ^ (uint32_t)k->flip;
+}
+
+static inline uint32_t key2(const void *ctx, const byte *p)
+{
+	register const key *k = ctx;
+	uint16_t u;
+	memcpy(&u, p + k->off, sizeof u);
+	return u ^ (uint32_t)k->flip;
+}
+
+static inline uint32_t key4(const void *ctx, const byte *p)
+{
+	register const key *k = ctx;
+	uint32_t u;
+	memcpy(&u, p + k->off, sizeof u);
+	return k->isfloat ? u ^ (-(u >> 31) | 0x80000000u)
+		: u ^ (uint32_t)k->flip;
+}
+
+static inline uint64_t key8(const void *ctx, const byte *p)
+{
+	register const key *k = ctx;
+	uint64_t u;
+	memcpy(&u, p + k->off, sizeof u);
+	return k->isfloat ? u ^ (-(u >> 63) | 0x8000000000000000u)
+		: u ^ k->flip;
+}
+
+/* Sorts of any element size, and of elements that are just their key */
+RADIX_SORT_DEF_(sort1, uint32_t, key1, (c->elsz))
+RADIX_SORT_DEF_(sort2, uint32_t, key2, (c->elsz))
+RADIX_SORT_DEF_(sort4, uint32_t, key4, (c->elsz))
+RADIX_SORT_DEF_(sort8, uint64_t, key8, (c->elsz))
+RADIX_SORT_DEF_(sortkey1, uint32_t, key1, 1)
+RADIX_SORT_DEF_(sortkey2, uint32_t, key2, 2)
+RADIX_SORT_DEF_(sortkey4, uint32_t, key4, 4)
+RADIX_SORT_DEF_(sortkey8, uint64_t, key8, 8)
+
+bool vpa_sort(vpa *foo, size_t keyoff, size_t keywidth, vpa_keytype type)
+{
+	if (!foo || keyoff > foo->elsz || keywidth > foo->elsz-keyoff
+			|| (type == VPA_KEY_FLOAT
+				&& keywidth != 4 && keywidth != 8))
+		return false;
+
+	void (*sort)(byte *, byte *, size_t, size_t, const void *);
+	register bool justkey = keywidth == foo->elsz;
+	switch (keywidth) {
+	case 1: sort = justkey ? sortkey1 : sort1; break;
+	case 2: sort = justkey ? sortkey2 : sort2; break;
+	case 4: sort = justkey ? sortkey4 : sort4; break;
+	case 8: sort = justkey ? sortkey8 : sort8; break;
+	default: return false;
+	}
+	if (foo->len < 2)
+		return true;
+
+	key k = {keyoff, 0, type == VPA_KEY_FLOAT};
+	if (type == VPA_KEY_SIGNED)
+		k.flip = (uint64_t)1 << (8*keywidth - 1);
+
+	/* Insertion sort holds one element aside, radix sort moves all.
+	 * Try .alloc first, which may only hold foo's block (see vpafile.h).
+	 */
+	size_t ntmp = foo->len < RADIX_SMALL ? 1 : foo->len;
+	vpa tmp = vpa_create_with(ntmp, foo->elsz, foo->alloc);
+	if (!tmp.arr && foo->alloc)
+		tmp = vpa_create(ntmp, foo->elsz);
+	if (!tmp.arr)
+		return false;
+	sort(foo->arr, tmp.arr, foo->len, foo->elsz, &k);
+	vpa_destroy(&tmp);
+	return true;
+}
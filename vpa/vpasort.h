@@ -0,0 +1,32 @@
+#ifndef VPASORT_H
+#define VPASORT_H
+
+#include <stdbool.h> /* bool   */
+#include <stddef.h>  /* size_t */
+
+#include "vpa.h"
+
+/* How vpa_sort() reads keys */
+typedef enum vpa_keytype {
+	VPA_KEY_UNSIGNED, /* Unsigned integers                  */
+	VPA_KEY_SIGNED,   /* Two's complement signed integers   */
+	VPA_KEY_FLOAT     /* IEEE 754 floats (4) or doubles (8) */
+} vpa_keytype;
+
+/* Stably sorts the elements in ascending order of their keys : the
+ * keywidth (1, 2, 4 or 8) bytes at keyoff of each, of the given type,
+ * in native byte order. Negative floats sort before positive ones, -0.0
+ * before 0.0, and NaNs after infinity or before -infinity, by their sign.
+ *
+ * Takes O(len) time and a scratch vpa of len elements, allocated with
+ * .alloc, or with vpa.c's realloc/free if that fails. Arrays of at least
+ * RADIX_PAR_MIN elements are sorted by several threads, unless vpasort.c
+ * is compiled with RADIX_NOTHREADS defined.
+ *
+ * Returns false, leaving the elements as they were, if the key is not
+ * within the elements, not of a valid width for its type, or if
+ * it can't allocate.
+ */
+bool vpa_sort(vpa *, size_t keyoff, size_t keywidth, vpa_keytype type);
+
+#endif